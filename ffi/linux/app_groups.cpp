@@ -0,0 +1,426 @@
+#include "include/app_groups.h"
+#include "include/running_app_info.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// How often the .desktop directories are checked for changes.
+static const int kDesktopRecheckSeconds = 5;
+
+struct DesktopApp {
+    string id;      // File name without ".desktop"
+    string name;
+    string icon;
+};
+
+// Indexes of the installed .desktop files.
+struct DesktopIndex {
+    unordered_map<string, DesktopApp> byId;
+    unordered_map<string, DesktopApp> byExec;   // Exec binary basename
+    vector<pair<string, time_t>> dirs;          // Directory and mtime at load
+    Clock::time_point checkedAt;
+};
+
+// Group assignment of one process; kept until the pid exits or is reused.
+struct GroupAssignment {
+    uint64_t startTicks;
+    string key;
+    string desktopHint;    // Desktop id derived from the cgroup scope, if any
+};
+
+struct AppGroup {
+    string key;
+    string name;
+    string desktopId;
+    string icon;
+    int mainPid;
+    uint64_t mainStartTicks;
+    vector<int> pids;
+    double cpuUsage;
+    uint64_t memoryUsage;  // Sum of RSS (KB), counts shared pages per process
+    uint64_t pss;          // Sum of PSS (KB) where deep memory data exists
+    double readBytesPerSec;
+    double writeBytesPerSec;
+};
+
+static mutex groupsMutex;
+static DesktopIndex desktopIndex;
+static unordered_map<int, GroupAssignment> assignments;
+
+static string basenameOf(const string& path) {
+    size_t pos = path.find_last_of('/');
+    return pos == string::npos ? path : path.substr(pos + 1);
+}
+
+static bool endsWith(const string& s, const char* suffix) {
+    size_t len = strlen(suffix);
+    return s.size() >= len && s.compare(s.size() - len, len, suffix) == 0;
+}
+
+static string dirnameOf(const string& path) {
+    size_t pos = path.find_last_of('/');
+    return pos == string::npos ? string() : path.substr(0, pos);
+}
+
+// Launchers and interpreters would match unrelated processes, so their Exec
+// lines are only reachable through the desktop id.
+static bool isGenericExec(const string& name) {
+    static const char* generic[] = {
+        "env", "sh", "bash", "dash", "zsh", "flatpak", "snap", "gjs", "node",
+        "java", "perl", "ruby", "python", "python2", "python3", "mono", "wine", "xdg-open"
+    };
+    for (const char* g : generic) {
+        if (name == g) return true;
+    }
+    return name.compare(0, 7, "python3") == 0;
+}
+
+// Returns the binary an Exec= line launches, skipping env and VAR=value tokens.
+static string execBinary(const string& exec) {
+    istringstream iss(exec);
+    string token;
+    while (iss >> token) {
+        if (!token.empty() && token.front() == '"') {
+            string rest;
+            while (token.back() != '"' && (iss >> rest)) token += " " + rest;
+            token = token.substr(1, token.size() > 1 ? token.size() - 2 : 0);
+        }
+        if (token == "env" || token.find('=') != string::npos) continue;
+        return basenameOf(token);
+    }
+    return "";
+}
+
+static void parseDesktopFile(const string& dir, const string& file) {
+    string text;
+    if (!readFile((dir + "/" + file).c_str(), text)) return;
+    DesktopApp app;
+    app.id = file.substr(0, file.size() - 8);
+    string exec;
+    bool inEntry = false;
+    istringstream iss(text);
+    string line;
+    while (getline(iss, line)) {
+        if (!line.empty() && line[0] == '[') {
+            inEntry = line == "[Desktop Entry]";
+            continue;
+        }
+        if (!inEntry) continue;
+        if (line.compare(0, 5, "Name=") == 0 && app.name.empty()) {
+            app.name = line.substr(5);
+        } else if (line.compare(0, 5, "Exec=") == 0 && exec.empty()) {
+            exec = line.substr(5);
+        } else if (line.compare(0, 5, "Icon=") == 0 && app.icon.empty()) {
+            app.icon = line.substr(5);
+        } else if (line == "Hidden=true") {
+            return;
+        }
+    }
+    if (app.name.empty()) return;
+    desktopIndex.byId[app.id] = app;
+    string binary = execBinary(exec);
+    if (!binary.empty() && !isGenericExec(binary)) {
+        // The first directory in XDG order wins, as with the id.
+        desktopIndex.byExec.emplace(binary, app);
+    }
+}
+
+static vector<string> desktopDirectories() {
+    vector<string> dirs;
+    const char* dataHome = getenv("XDG_DATA_HOME");
+    const char* home = getenv("HOME");
+    if (dataHome && *dataHome) {
+        dirs.push_back(string(dataHome) + "/applications");
+    } else if (home && *home) {
+        dirs.push_back(string(home) + "/.local/share/applications");
+    }
+    const char* dataDirs = getenv("XDG_DATA_DIRS");
+    string list = dataDirs && *dataDirs ? dataDirs : "/usr/local/share:/usr/share";
+    list += ":/var/lib/flatpak/exports/share:/var/lib/snapd/desktop";
+    istringstream iss(list);
+    string dir;
+    while (getline(iss, dir, ':')) {
+        if (!dir.empty()) dirs.push_back(dir + "/applications");
+    }
+    return dirs;
+}
+
+// Reloads the desktop index when one of the application dirs has changed.
+static void refreshDesktopIndex() {
+    Clock::time_point now = Clock::now();
+    if (desktopIndex.checkedAt != Clock::time_point() &&
+        now - desktopIndex.checkedAt < chrono::seconds(kDesktopRecheckSeconds)) {
+        return;
+    }
+    desktopIndex.checkedAt = now;
+
+    vector<pair<string, time_t>> current;
+    for (const string& dir : desktopDirectories()) {
+        struct stat st;
+        current.push_back({dir, stat(dir.c_str(), &st) == 0 ? st.st_mtime : 0});
+    }
+    if (current == desktopIndex.dirs) return;
+
+    desktopIndex.byId.clear();
+    desktopIndex.byExec.clear();
+    desktopIndex.dirs = current;
+    for (const auto& dir : current) {
+        DIR* d = opendir(dir.first.c_str());
+        if (!d) continue;
+        struct dirent* entry;
+        while ((entry = readdir(d)) != nullptr) {
+            size_t len = strlen(entry->d_name);
+            if (len > 8 && strcmp(entry->d_name + len - 8, ".desktop") == 0 &&
+                desktopIndex.byId.find(string(entry->d_name, len - 8)) == desktopIndex.byId.end()) {
+                parseDesktopFile(dir.first, entry->d_name);
+            }
+        }
+        closedir(d);
+    }
+}
+
+// Undoes systemd unit name escaping ("google\x2dchrome" -> "google-chrome").
+static string unescapeUnitName(const string& name) {
+    string result;
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] == '\\' && i + 3 < name.size() && name[i + 1] == 'x') {
+            result += (char)strtol(name.substr(i + 2, 2).c_str(), nullptr, 16);
+            i += 3;
+        } else {
+            result += name[i];
+        }
+    }
+    return result;
+}
+
+//
+// Extracts the application id from a systemd app unit in /proc/[pid]/cgroup:
+// app[-<launcher>]-<id>-<random>.scope or app[-<launcher>]-<id>[@<random>].service.
+// Returns an empty string for processes outside an app unit.
+//
+static string appUnitId(int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", pid);
+    string text;
+    if (!readFile(path, text)) return "";
+    size_t lineStart = text.compare(0, 3, "0::") == 0 ? 0 : text.find("\n0::");
+    if (lineStart == string::npos) return "";  // cgroup v1 hierarchy only
+    if (lineStart > 0) lineStart++;
+    size_t lineEnd = text.find('\n', lineStart);
+    string cgroup = text.substr(lineStart + 3, lineEnd == string::npos ? string::npos : lineEnd - lineStart - 3);
+
+    // The innermost app-*.scope / app-*.service component.
+    string unit;
+    size_t pos = cgroup.size();
+    while (pos > 0) {
+        size_t slash = cgroup.rfind('/', pos - 1);
+        size_t begin = slash == string::npos ? 0 : slash + 1;
+        string component = cgroup.substr(begin, pos - begin);
+        if (component.compare(0, 4, "app-") == 0 &&
+            (endsWith(component, ".scope") || endsWith(component, ".service"))) {
+            unit = component;
+            break;
+        }
+        if (slash == string::npos) break;
+        pos = slash;
+    }
+    if (unit.empty()) return "";
+
+    string id;
+    if (endsWith(unit, ".scope")) {
+        id = unit.substr(4, unit.size() - 10);
+        size_t dash = id.rfind('-');
+        if (dash != string::npos) id = id.substr(0, dash);   // Random suffix
+    } else {
+        id = unit.substr(4, unit.size() - 12);
+        size_t at = id.find('@');
+        if (at != string::npos) id = id.substr(0, at);
+    }
+    id = unescapeUnitName(id);
+
+    // Prefer a form that names an installed .desktop file.
+    if (desktopIndex.byId.count(id)) return id;
+    size_t dash = id.find('-');
+    if (dash != string::npos && desktopIndex.byId.count(id.substr(dash + 1))) {
+        return id.substr(dash + 1);
+    }
+    return id;
+}
+
+// Helpers and crash handlers usually live next to the main binary.
+static bool sharesInstallDir(const string& a, const string& b) {
+    static const char* systemDirs[] = {
+        "/usr/bin", "/bin", "/usr/sbin", "/sbin", "/usr/local/bin", "/usr/libexec", "/usr/lib"
+    };
+    string dir = dirnameOf(a);
+    if (dir.empty() || dir != dirnameOf(b)) return false;
+    for (const char* s : systemDirs) {
+        if (dir == s) return false;
+    }
+    return true;
+}
+
+// Decides which group a newly seen process belongs to.
+static GroupAssignment classify(const ProgramInfo& p, const unordered_map<int, const ProgramInfo*>& byPid) {
+    GroupAssignment a;
+    a.startTicks = p.startTicks;
+    if (p.pid == 2 || p.parentPid == 2) {
+        a.key = "kernel";
+        return a;
+    }
+    a.desktopHint = appUnitId(p.pid);
+    if (!a.desktopHint.empty()) {
+        a.key = "unit:" + a.desktopHint;
+        return a;
+    }
+
+    // Climb while the parent runs the same binary or one from the same install dir.
+    const ProgramInfo* root = &p;
+    for (int depth = 0; depth < 64; depth++) {
+        auto parent = byPid.find(root->parentPid);
+        if (parent == byPid.end() || parent->second->pid <= 1) break;
+        const ProgramInfo* pp = parent->second;
+        bool same = root->executablePath != "0" && pp->executablePath != "0" &&
+            (pp->executablePath == root->executablePath || sharesInstallDir(pp->executablePath, root->executablePath));
+        if (!same) break;
+        root = pp;
+    }
+    // Keyed by the root process too: separate launches of a shared binary
+    // (python, node, electron) are different applications.
+    string rootId = "@" + to_string(root->pid) + "." + to_string(root->startTicks);
+    a.key = (root->executablePath != "0" ? "exe:" + root->executablePath : "name:" + root->name) + rootId;
+    return a;
+}
+
+static void nameGroup(AppGroup& group, const ProgramInfo& main, const string& desktopHint) {
+    const DesktopApp* app = nullptr;
+    if (!desktopHint.empty()) {
+        auto it = desktopIndex.byId.find(desktopHint);
+        if (it != desktopIndex.byId.end()) app = &it->second;
+    }
+    if (!app) {
+        string binary = main.executablePath != "0" ? basenameOf(main.executablePath) : main.name;
+        auto it = desktopIndex.byExec.find(binary);
+        if (it != desktopIndex.byExec.end()) app = &it->second;
+    }
+    if (app) {
+        group.name = app->name;
+        group.desktopId = app->id;
+        group.icon = app->icon;
+    } else if (group.key == "kernel") {
+        group.name = "Kernel";
+    } else if (!desktopHint.empty()) {
+        group.name = desktopHint;
+    } else {
+        group.name = main.name;
+    }
+}
+
+//
+// Each tick takes the latest /proc sweep (shared with the process list),
+// classifies only processes not seen before and re-sums the aggregates, so
+// the cost is at most one pass over the process table.
+//
+static string getApplicationGroupsJSON_Internal() {
+    vector<ProgramInfo> programs = collectRunningPrograms();
+    if (programs.empty()) {
+        return "{ \"applications\": 0 }";
+    }
+
+    lock_guard<mutex> lock(groupsMutex);
+    refreshDesktopIndex();
+
+    unordered_map<int, const ProgramInfo*> byPid;
+    byPid.reserve(programs.size());
+    for (const ProgramInfo& p : programs) byPid[p.pid] = &p;
+
+    unordered_map<int, GroupAssignment> live;
+    live.reserve(programs.size());
+    unordered_map<string, AppGroup> groups;
+    unordered_map<string, string> groupHints;
+    for (const ProgramInfo& p : programs) {
+        auto it = assignments.find(p.pid);
+        GroupAssignment a = (it != assignments.end() && it->second.startTicks == p.startTicks)
+            ? it->second : classify(p, byPid);
+
+        AppGroup& g = groups[a.key];
+        if (g.pids.empty()) {
+            g.key = a.key;
+            g.mainPid = p.pid;
+            g.mainStartTicks = p.startTicks;
+            g.cpuUsage = g.readBytesPerSec = g.writeBytesPerSec = 0.0;
+            g.memoryUsage = g.pss = 0;
+        } else if (p.startTicks < g.mainStartTicks) {
+            g.mainPid = p.pid;
+            g.mainStartTicks = p.startTicks;
+        }
+        g.pids.push_back(p.pid);
+        g.cpuUsage += p.cpuUsage;
+        g.memoryUsage += (uint64_t)p.memoryUsage;
+        g.pss += p.deepMemory.ageMs >= 0 ? p.deepMemory.pss : 0;
+        g.readBytesPerSec += p.readBytesPerSec;
+        g.writeBytesPerSec += p.writeBytesPerSec;
+        if (!a.desktopHint.empty()) groupHints[a.key] = a.desktopHint;
+        live[p.pid] = std::move(a);
+    }
+    assignments.swap(live);
+
+    vector<AppGroup*> sorted;
+    sorted.reserve(groups.size());
+    for (auto& entry : groups) {
+        AppGroup& g = entry.second;
+        nameGroup(g, *byPid[g.mainPid], groupHints[g.key]);
+        sorted.push_back(&g);
+    }
+    sort(sorted.begin(), sorted.end(), [](const AppGroup* a, const AppGroup* b) {
+        if (a->cpuUsage != b->cpuUsage) return a->cpuUsage > b->cpuUsage;
+        return a->memoryUsage > b->memoryUsage;
+    });
+
+    // Build JSON output.
+    ostringstream json;
+    json << "{ \"applications\": [";
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const AppGroup& g = *sorted[i];
+        json << "{";
+        json << "\"name\": \"" << jsonEscape(g.name) << "\", ";
+        json << "\"key\": \"" << jsonEscape(g.key) << "\", ";
+        json << "\"desktopId\": \"" << jsonEscape(g.desktopId) << "\", ";
+        json << "\"icon\": \"" << jsonEscape(g.icon) << "\", ";
+        json << "\"mainPid\": " << g.mainPid << ", ";
+        json << "\"processCount\": " << g.pids.size() << ", ";
+        json << "\"cpuUsage\": " << g.cpuUsage << ", ";
+        json << "\"memoryUsage\": " << g.memoryUsage << ", ";
+        json << "\"pss\": " << g.pss << ", ";
+        json << "\"readBytesPerSec\": " << g.readBytesPerSec << ", ";
+        json << "\"writeBytesPerSec\": " << g.writeBytesPerSec << ", ";
+        json << "\"pids\": [";
+        for (size_t j = 0; j < g.pids.size(); j++) {
+            if (j > 0) json << ", ";
+            json << g.pids[j];
+        }
+        json << "]}";
+        if (i < sorted.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getApplicationGroupsJSON() {
+    return strdup_cstr(getApplicationGroupsJSON_Internal());
+}
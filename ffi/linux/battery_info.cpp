@@ -0,0 +1,309 @@
+#include "include/battery_info.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include "include/uevent_monitor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+
+using namespace std;
+
+static mutex powerMutex;
+static string sysfsRoot = "/sys";
+
+// Which supplies are system batteries and whether AC is online only change
+// with a power_supply uevent, so they are cached until one arrives. Battery
+// levels are still read on every call. Guarded by supplyMutex.
+static mutex supplyMutex;
+static vector<string> cachedBatteryNames;
+static bool cachedAcOnline = false;
+static bool supplyCacheValid = false;
+static int ueventFd = -2;          // -2: not opened yet, -1: unavailable
+static uint64_t acChangedNs = 0;
+
+// Wall-clock time a battery was last seen "Full", 0 if never.
+static time_t lastFullAt = 0;
+
+static string powerSupplyDir() {
+    lock_guard<mutex> lock(powerMutex);
+    return sysfsRoot + "/class/power_supply";
+}
+
+// Fields of a power_supply uevent file that the collector uses.
+struct SupplyFields {
+    string type;
+    bool online = false;
+    BatteryReading battery;
+    uint64_t chargeNow = 0;
+    uint64_t currentNow = 0;
+};
+
+// Parses "POWER_SUPPLY_KEY=value" lines in a single pass.
+static void parseSupplyUevent(const string& text, SupplyFields& f) {
+    BatteryReading& b = f.battery;
+    b.capacityPercent = -1;
+    b.energyNow = b.energyFull = b.energyFullDesign = 0;
+    b.chargeFull = b.chargeFullDesign = 0;
+    b.powerNow = b.voltageNow = b.voltageMinDesign = 0;
+    b.cycleCount = -1;
+    b.temperatureC = 0.0;
+
+    static const char kPrefix[] = "POWER_SUPPLY_";
+    const size_t prefixLen = sizeof(kPrefix) - 1;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == string::npos) eol = text.size();
+        size_t eq = text.find('=', pos);
+        if (eq < eol && text.compare(pos, prefixLen, kPrefix) == 0) {
+            const string key = text.substr(pos + prefixLen, eq - pos - prefixLen);
+            const string value = text.substr(eq + 1, eol - eq - 1);
+            const char* v = value.c_str();
+            // Some drivers report negative currents/power while discharging.
+            uint64_t magnitude = strtoull(v[0] == '-' ? v + 1 : v, nullptr, 10);
+            if (key == "TYPE") f.type = value;
+            else if (key == "ONLINE") f.online = value == "1";
+            else if (key == "STATUS") b.status = value;
+            else if (key == "TECHNOLOGY") b.technology = value;
+            else if (key == "MANUFACTURER") b.manufacturer = value;
+            else if (key == "MODEL_NAME") b.model = value;
+            else if (key == "CAPACITY") b.capacityPercent = atoi(v);
+            else if (key == "ENERGY_NOW") b.energyNow = magnitude;
+            else if (key == "ENERGY_FULL") b.energyFull = magnitude;
+            else if (key == "ENERGY_FULL_DESIGN") b.energyFullDesign = magnitude;
+            else if (key == "CHARGE_NOW") f.chargeNow = magnitude;
+            else if (key == "CHARGE_FULL") b.chargeFull = magnitude;
+            else if (key == "CHARGE_FULL_DESIGN") b.chargeFullDesign = magnitude;
+            else if (key == "POWER_NOW") b.powerNow = magnitude;
+            else if (key == "CURRENT_NOW") f.currentNow = magnitude;
+            else if (key == "VOLTAGE_NOW") b.voltageNow = magnitude;
+            else if (key == "VOLTAGE_MIN_DESIGN") b.voltageMinDesign = magnitude;
+            else if (key == "CYCLE_COUNT") b.cycleCount = atoi(v);
+            else if (key == "TEMP") b.temperatureC = atoi(v) / 10.0;
+        }
+        pos = eol + 1;
+    }
+
+    // Charge-based batteries: µAh * V = µWh.
+    if (b.energyFull == 0 && b.chargeFull > 0) {
+        double volts = (b.voltageMinDesign ? b.voltageMinDesign : b.voltageNow) / 1e6;
+        b.energyNow = (uint64_t)(f.chargeNow * volts);
+        b.energyFull = (uint64_t)(b.chargeFull * volts);
+        b.energyFullDesign = (uint64_t)(b.chargeFullDesign * volts);
+    }
+    if (b.powerNow == 0 && f.currentNow > 0) {
+        b.powerNow = (uint64_t)((double)f.currentNow * b.voltageNow / 1e6);
+    }
+}
+
+static bool readSupply(const string& dir, const char* name, SupplyFields& f) {
+    string text;
+    if (!readFile((dir + "/" + name + "/uevent").c_str(), text)) return false;
+    parseSupplyUevent(text, f);
+    // Older kernels leave TYPE out of the uevent.
+    if (f.type.empty() && readFile((dir + "/" + name + "/type").c_str(), text)) {
+        f.type = text.substr(0, text.find('\n'));
+    }
+    f.battery.name = name;
+    return true;
+}
+
+// Scans every supply once, filling `batteries`; returns whether any
+// external supply (mains or USB-PD) is online.
+static bool scanSupplies(vector<BatteryReading>& batteries) {
+    string dir = powerSupplyDir();
+    bool online = false;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return false;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        SupplyFields f;
+        if (!readSupply(dir, entry->d_name, f)) continue;
+        if (f.type == "Battery") {
+            // Peripheral batteries (mice, headsets) have "scope" Device.
+            string scope;
+            if (readFile((dir + "/" + entry->d_name + "/scope").c_str(), scope) &&
+                scope.compare(0, 6, "Device") == 0) {
+                continue;
+            }
+            batteries.push_back(f.battery);
+        } else if (f.online) {
+            online = true;
+        }
+    }
+    closedir(d);
+    sort(batteries.begin(), batteries.end(),
+         [](const BatteryReading& a, const BatteryReading& b) { return a.name < b.name; });
+    return online;
+}
+
+// Re-reads only the cached batteries. False if one has gone away, which
+// means the cache missed an event.
+static bool readCachedBatteries(vector<BatteryReading>& batteries) {
+    string dir = powerSupplyDir();
+    for (const string& name : cachedBatteryNames) {
+        SupplyFields f;
+        if (!readSupply(dir, name.c_str(), f)) return false;
+        batteries.push_back(f.battery);
+    }
+    return true;
+}
+
+PowerSupplySnapshot readPowerSupplies() {
+    PowerSupplySnapshot snap;
+    {
+        lock_guard<mutex> lock(supplyMutex);
+        if (ueventFd == -2) ueventFd = openUeventSocket();
+        // Without a uevent socket every call rescans, as AC changes would
+        // otherwise go unnoticed.
+        if (ueventFd < 0 || drainUevents(ueventFd, "power_supply")) supplyCacheValid = false;
+        if (supplyCacheValid && !readCachedBatteries(snap.batteries)) {
+            snap.batteries.clear();
+            supplyCacheValid = false;
+        }
+        if (!supplyCacheValid) {
+            bool online = scanSupplies(snap.batteries);
+            if (online != cachedAcOnline) acChangedNs = monotonicNanos();
+            cachedAcOnline = online;
+            cachedBatteryNames.clear();
+            for (const BatteryReading& b : snap.batteries) cachedBatteryNames.push_back(b.name);
+            supplyCacheValid = true;
+        }
+        snap.acOnline = cachedAcOnline;
+        snap.acChangedNs = acChangedNs;
+    }
+    bool full = false;
+    for (const BatteryReading& b : snap.batteries) full = full || b.status == "Full";
+    if (full) {
+        lock_guard<mutex> lock(powerMutex);
+        lastFullAt = time(nullptr);
+    }
+    return snap;
+}
+
+void setPowerSupplyRoot(const char* root) {
+    {
+        lock_guard<mutex> lock(powerMutex);
+        sysfsRoot = root && *root ? root : "/sys";
+    }
+    lock_guard<mutex> lock(supplyMutex);
+    supplyCacheValid = false;
+}
+
+static string isoTime(time_t t) {
+    char buf[32];
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%FT%TZ", &tm);
+    return buf;
+}
+
+// µWh -> mAh at the battery's design (or present) voltage.
+static double energyToMah(uint64_t energy, const BatteryReading& b) {
+    uint64_t microvolts = b.voltageMinDesign ? b.voltageMinDesign : b.voltageNow;
+    return microvolts ? (double)energy / (double)microvolts * 1000.0 : 0.0;
+}
+
+//
+// Same keys as the macOS BatteryInfo JSON, summed over all system batteries,
+// plus a per-battery array.
+//
+static string displayBatteryInfo() {
+    PowerSupplySnapshot snap = readPowerSupplies();
+
+    uint64_t energyNow = 0, energyFull = 0, energyDesign = 0;
+    double maxCapacity = 0.0, designedCapacity = 0.0;
+    double voltage = 0.0, temperature = 0.0;
+    int cycleCount = 0;
+    bool charging = false;
+    string technology = "Unknown";
+    for (const BatteryReading& b : snap.batteries) {
+        energyNow += b.energyNow;
+        energyFull += b.energyFull;
+        energyDesign += b.energyFullDesign;
+        maxCapacity += b.chargeFull ? b.chargeFull / 1000.0 : energyToMah(b.energyFull, b);
+        designedCapacity += b.chargeFullDesign ? b.chargeFullDesign / 1000.0 : energyToMah(b.energyFullDesign, b);
+        voltage = max(voltage, b.voltageNow / 1e6);
+        temperature = max(temperature, b.temperatureC);
+        cycleCount = max(cycleCount, b.cycleCount);
+        charging = charging || b.status == "Charging";
+        if (!b.technology.empty() && technology == "Unknown") technology = b.technology;
+    }
+
+    double chargeLevel = 0.0;
+    if (energyFull > 0) {
+        chargeLevel = min(100.0, (double)energyNow / (double)energyFull * 100.0);
+    } else if (!snap.batteries.empty() && snap.batteries[0].capacityPercent >= 0) {
+        chargeLevel = snap.batteries[0].capacityPercent;
+    }
+
+    // Health is the remaining full capacity relative to design.
+    double healthPercent = energyDesign > 0 ? min(100.0, (double)energyFull / (double)energyDesign * 100.0) : 0.0;
+    string healthQual = "Unknown";
+    if (energyDesign > 0) {
+        if (healthPercent >= 90.0) {
+            healthQual = "Good";
+        } else if (healthPercent >= 80.0) {
+            healthQual = "Normal";
+        } else {
+            healthQual = "Bad";
+        }
+    }
+
+    time_t fullAt;
+    {
+        lock_guard<mutex> lock(powerMutex);
+        fullAt = lastFullAt;
+    }
+    // Matches macOS, which also reports "now" when the time is unknown.
+    string lastFullChargeTime = isoTime(fullAt ? fullAt : time(nullptr));
+
+    ostringstream json;
+    json << "{\n";
+    json << "  \"chargeLevel\": " << fixed << setprecision(1) << chargeLevel << ",\n";
+    json << "  \"isCharging\": " << (charging ? "true" : "false") << ",\n";
+    json << "  \"isConnectedToPower\": " << (snap.acOnline ? "true" : "false") << ",\n";
+    json << "  \"health\": \"" << healthQual << "\",\n";
+    json << "  \"technology\": \"" << jsonEscape(technology) << "\",\n";
+    json << "  \"cycleCount\": " << cycleCount << ",\n";
+    json << "  \"temperature\": " << fixed << setprecision(2) << temperature << ",\n";
+    json << "  \"voltage\": " << fixed << setprecision(2) << voltage << ",\n";
+    json << "  \"currentCapacity\": " << fixed << setprecision(0) << healthPercent << ",\n";
+    json << "  \"maxCapacity\": " << fixed << setprecision(0) << maxCapacity << ",\n";
+    json << "  \"designedCapacity\": " << fixed << setprecision(0) << designedCapacity << ",\n";
+    json << "  \"powerSource\": \"" << (snap.acOnline ? "AC" : "Battery") << "\",\n";
+    json << "  \"lastFullChargeTime\": \"" << lastFullChargeTime << "\",\n";
+    json << "  \"batteries\": [";
+    for (size_t i = 0; i < snap.batteries.size(); i++) {
+        const BatteryReading& b = snap.batteries[i];
+        json << "{\"name\": \"" << jsonEscape(b.name) << "\", ";
+        json << "\"status\": \"" << jsonEscape(b.status) << "\", ";
+        json << "\"manufacturer\": \"" << jsonEscape(b.manufacturer) << "\", ";
+        json << "\"model\": \"" << jsonEscape(b.model) << "\", ";
+        json << "\"capacity\": " << b.capacityPercent << ", ";
+        json << "\"energyNow\": " << b.energyNow << ", ";
+        json << "\"energyFull\": " << b.energyFull << ", ";
+        json << "\"energyFullDesign\": " << b.energyFullDesign << ", ";
+        json << "\"powerNow\": " << b.powerNow << ", ";
+        json << "\"voltageNow\": " << b.voltageNow << ", ";
+        json << "\"cycleCount\": " << b.cycleCount << "}";
+        if (i < snap.batteries.size() - 1)
+            json << ", ";
+    }
+    json << "]\n";
+    json << "}\n";
+    return json.str();
+}
+
+char* getBatteryInfo() {
+    return strdup_cstr(displayBatteryInfo());
+}
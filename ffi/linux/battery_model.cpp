@@ -0,0 +1,224 @@
+#include "include/battery_model.h"
+#include "include/battery_info.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const size_t kMaxSessions = 64;
+// Samples needed before the variance is trusted enough to report a band.
+static const uint64_t kMinSamplesForBand = 5;
+
+enum class PowerState { Idle, Charging, Discharging };
+
+struct ModelState {
+    PowerState state = PowerState::Idle;
+    double tauSeconds = 120.0;
+    double ewma = 0.0;           // Watts
+    double variance = 0.0;
+    uint64_t samples = 0;
+    uint64_t lastNs = 0;
+    double instant = 0.0;
+    double percent = 0.0;
+    double energyNowWh = 0.0;
+    double energyFullWh = 0.0;
+    // Fallback rate for batteries without power_now/current_now: energy_now
+    // only moves in coarse steps, so the rate is taken between changes.
+    double lastEnergyWh = -1.0;
+    uint64_t lastEnergyChangeNs = 0;
+    deque<ChargeSession> sessions;
+    double sessionStartEnergyWh = 0.0;
+};
+
+static mutex modelMutex;
+static ModelState model;
+
+static const char* stateName(PowerState s) {
+    switch (s) {
+        case PowerState::Charging: return "Charging";
+        case PowerState::Discharging: return "Discharging";
+        default: return "Idle";
+    }
+}
+
+// Caller holds modelMutex.
+static void closeSession(time_t now) {
+    if (model.sessions.empty() || model.sessions.back().end != 0) return;
+    ChargeSession& s = model.sessions.back();
+    s.end = now;
+    s.endPercent = model.percent;
+    s.energyWh = fabs(model.energyNowWh - model.sessionStartEnergyWh);
+    double hours = difftime(s.end, s.start) / 3600.0;
+    s.averageWatts = hours > 0 ? s.energyWh / hours : 0.0;
+}
+
+static void sampleBattery(uint64_t nowNs) {
+    PowerSupplySnapshot snap = readPowerSupplies();
+    double energyNow = 0.0, energyFull = 0.0, power = 0.0;
+    bool charging = false, discharging = false;
+    for (const BatteryReading& b : snap.batteries) {
+        energyNow += b.energyNow / 1e6;
+        energyFull += b.energyFull / 1e6;
+        power += b.powerNow / 1e6;
+        charging = charging || b.status == "Charging";
+        discharging = discharging || b.status == "Discharging";
+    }
+    PowerState state = PowerState::Idle;
+    if (charging) state = PowerState::Charging;
+    else if (discharging && !snap.acOnline) state = PowerState::Discharging;
+    time_t wallNow = time(nullptr);
+
+    lock_guard<mutex> lock(modelMutex);
+    model.energyNowWh = energyNow;
+    model.energyFullWh = energyFull;
+    model.percent = energyFull > 0 ? min(100.0, energyNow / energyFull * 100.0) : 0.0;
+
+    if (state != model.state || snap.batteries.empty()) {
+        closeSession(wallNow);
+        model.state = snap.batteries.empty() ? PowerState::Idle : state;
+        model.ewma = model.variance = 0.0;
+        model.samples = 0;
+        model.lastEnergyWh = -1.0;
+        if (model.state != PowerState::Idle) {
+            if (model.sessions.size() == kMaxSessions) model.sessions.pop_front();
+            model.sessions.push_back(ChargeSession{model.state == PowerState::Charging, wallNow, 0,
+                                                   model.percent, model.percent, 0.0, 0.0});
+            model.sessionStartEnergyWh = energyNow;
+        }
+    }
+
+    if (power <= 0.0) {
+        // No instantaneous reading: use the slope between energy steps.
+        if (model.lastEnergyWh < 0) {
+            model.lastEnergyWh = energyNow;
+            model.lastEnergyChangeNs = nowNs;
+        } else if (energyNow != model.lastEnergyWh) {
+            double hours = (nowNs - model.lastEnergyChangeNs) / 3.6e12;
+            power = hours > 0 ? fabs(energyNow - model.lastEnergyWh) / hours : 0.0;
+            model.lastEnergyWh = energyNow;
+            model.lastEnergyChangeNs = nowNs;
+        }
+    }
+    model.instant = power;
+
+    if (model.state != PowerState::Idle && power > 0.0) {
+        if (model.samples == 0) {
+            model.ewma = power;
+            model.variance = 0.0;
+        } else {
+            // Time-aware EWMA so changing the sampling interval keeps the same
+            // smoothing horizon; variance uses the same weights.
+            double dt = (nowNs - model.lastNs) / 1e9;
+            double alpha = 1.0 - exp(-dt / model.tauSeconds);
+            double diff = power - model.ewma;
+            model.ewma += alpha * diff;
+            model.variance = (1.0 - alpha) * (model.variance + alpha * diff * diff);
+        }
+        model.samples++;
+        model.lastNs = nowNs;
+    }
+}
+
+static void ensureBatterySampler() {
+    registerSampler("battery", sampleBattery);
+}
+
+// Minutes to move `energyWh` at `watts`, -1 if the rate is unusable.
+static double minutesAt(double energyWh, double watts) {
+    return watts > 0.01 ? energyWh / watts * 60.0 : -1.0;
+}
+
+BatteryEstimate batteryEstimate() {
+    ensureBatterySampler();
+    lock_guard<mutex> lock(modelMutex);
+    BatteryEstimate e;
+    e.state = stateName(model.state);
+    e.percent = model.percent;
+    e.instantWatts = model.instant;
+    e.ewmaWatts = model.ewma;
+    e.stddevWatts = sqrt(model.variance);
+    e.samples = model.samples;
+    e.minutesToEmpty = e.minutesToEmptyLow = e.minutesToEmptyHigh = -1.0;
+    e.minutesToFull = e.minutesToFullLow = e.minutesToFullHigh = -1.0;
+
+    if (model.samples > 0) {
+        double remaining = model.state == PowerState::Charging
+            ? max(0.0, model.energyFullWh - model.energyNowWh) : model.energyNowWh;
+        double mid = minutesAt(remaining, model.ewma);
+        double lowRate = model.ewma, highRate = model.ewma;
+        if (model.samples >= kMinSamplesForBand) {
+            lowRate = max(0.0, model.ewma - 1.96 * e.stddevWatts);
+            highRate = model.ewma + 1.96 * e.stddevWatts;
+        }
+        // A faster rate gives the shorter (low) estimate.
+        double low = minutesAt(remaining, highRate);
+        double high = minutesAt(remaining, lowRate);
+        if (model.state == PowerState::Charging) {
+            e.minutesToFull = mid;
+            e.minutesToFullLow = low;
+            e.minutesToFullHigh = high;
+        } else if (model.state == PowerState::Discharging) {
+            e.minutesToEmpty = mid;
+            e.minutesToEmptyLow = low;
+            e.minutesToEmptyHigh = high;
+        }
+    }
+
+    e.sessions.assign(model.sessions.begin(), model.sessions.end());
+    if (!e.sessions.empty() && e.sessions.back().end == 0) {
+        ChargeSession& open = e.sessions.back();
+        open.endPercent = model.percent;
+        open.energyWh = fabs(model.energyNowWh - model.sessionStartEnergyWh);
+        double hours = difftime(time(nullptr), open.start) / 3600.0;
+        open.averageWatts = hours > 0 ? open.energyWh / hours : 0.0;
+    }
+    return e;
+}
+
+void setBatteryModelTimeConstant(int seconds) {
+    lock_guard<mutex> lock(modelMutex);
+    model.tauSeconds = min(3600, max(5, seconds));
+}
+
+static string getBatteryModelJSON_Internal() {
+    BatteryEstimate e = batteryEstimate();
+    ostringstream json;
+    json << "{ \"state\": \"" << e.state << "\", ";
+    json << "\"percent\": " << e.percent << ", ";
+    json << "\"instantWatts\": " << e.instantWatts << ", ";
+    json << "\"ewmaWatts\": " << e.ewmaWatts << ", ";
+    json << "\"stddevWatts\": " << e.stddevWatts << ", ";
+    json << "\"samples\": " << e.samples << ", ";
+    json << "\"minutesToEmpty\": " << e.minutesToEmpty << ", ";
+    json << "\"minutesToEmptyLow\": " << e.minutesToEmptyLow << ", ";
+    json << "\"minutesToEmptyHigh\": " << e.minutesToEmptyHigh << ", ";
+    json << "\"minutesToFull\": " << e.minutesToFull << ", ";
+    json << "\"minutesToFullLow\": " << e.minutesToFullLow << ", ";
+    json << "\"minutesToFullHigh\": " << e.minutesToFullHigh << ", ";
+    json << "\"sessions\": [";
+    for (size_t i = 0; i < e.sessions.size(); i++) {
+        const ChargeSession& s = e.sessions[i];
+        json << "{\"charging\": " << (s.charging ? "true" : "false") << ", ";
+        json << "\"start\": " << (long long)s.start << ", ";
+        json << "\"end\": " << (long long)s.end << ", ";
+        json << "\"startPercent\": " << s.startPercent << ", ";
+        json << "\"endPercent\": " << s.endPercent << ", ";
+        json << "\"energyWh\": " << s.energyWh << ", ";
+        json << "\"averageWatts\": " << s.averageWatts << "}";
+        if (i < e.sessions.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getBatteryModelJSON() {
+    return strdup_cstr(getBatteryModelJSON_Internal());
+}
@@ -0,0 +1,101 @@
+// Opens listening sockets on loopback and times full TCP dumps via sock_diag
+// against parsing /proc/net/tcp{,6}. Kept out of the library: it holds up to
+// half a million sockets and raises RLIMIT_NOFILE for its own process.
+//
+//   connection_benchmark [sockets] [iterations]    (default 10000, 5)
+#include "../include/connection_table.h"
+#include "../include/open_files.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+//
+// Listening sockets are spread over 127.0.0.1-127.0.0.16 so the count is
+// not capped by the ephemeral port range of a single address.
+//
+static vector<int> openListeners(int count) {
+    vector<int> fds;
+    fds.reserve((size_t)count);
+    int failuresInARow = 0;
+    for (int i = 0; fds.size() < (size_t)count && failuresInARow < 16; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) break; // EMFILE/ENFILE
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(0x7f000001 + (uint32_t)(i % 16));
+        addr.sin_port = 0;
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+            close(fd);
+            failuresInARow++; // That address ran out of ports
+            continue;
+        }
+        failuresInARow = 0;
+        fds.push_back(fd);
+    }
+    return fds;
+}
+
+// Raises the soft descriptor limit (and the hard one with CAP_SYS_RESOURCE)
+// to fit `sockets` listeners; returns how many can actually be opened.
+static int reserveDescriptors(int sockets) {
+    rlim_t wanted = (rlim_t)sockets + 64;
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < wanted) {
+        struct rlimit raised = limit;
+        raised.rlim_cur = min(wanted, limit.rlim_max);
+        if (limit.rlim_max < wanted) {
+            raised.rlim_cur = raised.rlim_max = wanted;
+            if (setrlimit(RLIMIT_NOFILE, &raised) != 0) raised.rlim_cur = raised.rlim_max = limit.rlim_max;
+        }
+        setrlimit(RLIMIT_NOFILE, &raised);
+    }
+    // Leave descriptors for the netlink socket and the /proc files.
+    getrlimit(RLIMIT_NOFILE, &limit);
+    rlim_t usable = limit.rlim_cur > 64 ? limit.rlim_cur - 64 : 0;
+    return (rlim_t)sockets > usable ? (int)usable : sockets;
+}
+
+int main(int argc, char** argv) {
+    using BenchClock = chrono::steady_clock;
+    int requested = argc > 1 ? atoi(argv[1]) : 10000;
+    requested = max(0, min(requested, 500000));
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    iterations = max(1, min(iterations, 1000));
+
+    vector<int> listeners = openListeners(reserveDescriptors(requested));
+
+    vector<TcpConnection> connections;
+    size_t diagRows = 0, procRows = 0;
+    bool sockDiag = true;
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations && sockDiag; i++) {
+        sockDiag = dumpTcpConnections(0, connections);
+        diagRows = connections.size();
+    }
+    double diagMs = chrono::duration<double, milli>(BenchClock::now() - start).count() / iterations;
+
+    start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) procRows = readTcpSocketTable().size();
+    double procMs = chrono::duration<double, milli>(BenchClock::now() - start).count() / iterations;
+
+    for (int fd : listeners) close(fd);
+
+    printf("{ \"requestedSockets\": %d, \"openedSockets\": %zu, \"iterations\": %d, "
+           "\"sockDiagAvailable\": %s, \"sockDiagRows\": %zu, \"procfsRows\": %zu, "
+           "\"sockDiagMs\": %g, \"procfsMs\": %g, \"speedup\": %g }\n",
+           requested, listeners.size(), iterations, sockDiag ? "true" : "false", diagRows, procRows,
+           diagMs, procMs, sockDiag && diagMs > 0 ? procMs / diagMs : 0.0);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Times osInfo() (cached and cold) against gathering the same fields with
+// popen, as the macOS implementation does. Kept out of the library: the
+// popen rounds fork about ten shells each.
+//
+//   os_info_benchmark [iterations]    (default 1000)
+#include "../include/os_info.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+// Runs a command the way the macOS implementation does.
+static string execCommand(const char* cmd) {
+    char buffer[256];
+    string result;
+    FILE* pipe = popen(cmd, "r");
+    if (!pipe) return "Error";
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        result += buffer;
+    }
+    pclose(pipe);
+    return result;
+}
+
+// The same ten fields, one subprocess each.
+static size_t gatherWithPopen() {
+    static const char* commands[] = {
+        ". /etc/os-release && echo \"$NAME\"", ". /etc/os-release && echo \"$VERSION_ID\"",
+        "uname -v", "uname -r", "uname -m", "cat /proc/uptime", "hostname", "hostname",
+        "whoami", "echo \"$LANG\""
+    };
+    size_t bytes = 0;
+    for (const char* cmd : commands) bytes += execCommand(cmd).size();
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    using BenchClock = chrono::steady_clock;
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    iterations = max(1, min(iterations, 100000));
+    // Each popen round forks ten shells, so it gets far fewer rounds.
+    const int popenIterations = max(1, min(iterations, 20));
+    size_t sink = 0;
+
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) sink += buildOsInfoJson(false).size();
+    double coldUs = chrono::duration<double, micro>(BenchClock::now() - start).count() / iterations;
+
+    start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) sink += buildOsInfoJson(true).size();
+    double cachedUs = chrono::duration<double, micro>(BenchClock::now() - start).count() / iterations;
+
+    start = BenchClock::now();
+    for (int i = 0; i < popenIterations; i++) sink += gatherWithPopen();
+    double popenUs = chrono::duration<double, micro>(BenchClock::now() - start).count() / popenIterations;
+
+    printf("{ \"iterations\": %d, \"popenIterations\": %d, \"cachedMicros\": %g, \"uncachedMicros\": %g, "
+           "\"popenMicros\": %g, \"speedupCached\": %g, \"speedupUncached\": %g, \"bytes\": %zu }\n",
+           iterations, popenIterations, cachedUs, coldUs, popenUs,
+           cachedUs > 0 ? popenUs / cachedUs : 0.0, coldUs > 0 ? popenUs / coldUs : 0.0, sink);
+    return 0;
+}
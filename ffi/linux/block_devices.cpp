@@ -0,0 +1,218 @@
+#include "include/block_devices.h"
+#include "include/mount_table.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include "include/uevent_monitor.h"
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+using namespace std;
+
+// Without a uevent socket the cache is simply refreshed this often.
+static const time_t kFallbackRefreshSeconds = 30;
+
+static mutex blockMutex;
+static vector<BlockDevice> cachedDevices;
+static bool cacheValid = false;
+static int ueventFd = -2;          // -2: not opened yet, -1: unavailable
+static time_t cachedAt = 0;
+
+// Single-line sysfs attribute without the trailing newline/padding.
+static string readAttribute(const string& path) {
+    string value;
+    if (!readFile(path.c_str(), value)) return "";
+    size_t end = value.find_last_not_of(" \n\t");
+    return end == string::npos ? "" : value.substr(0, end + 1);
+}
+
+static uint64_t readNumber(const string& path) {
+    return strtoull(readAttribute(path).c_str(), nullptr, 10);
+}
+
+static vector<string> listDirectory(const string& path) {
+    vector<string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return names;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    return names;
+}
+
+// "none [mq-deadline] kyber" -> "mq-deadline"; a single entry has no brackets.
+static string activeScheduler(const string& text) {
+    size_t open = text.find('[');
+    size_t close = text.find(']', open);
+    if (open != string::npos && close != string::npos) return text.substr(open + 1, close - open - 1);
+    return text;
+}
+
+static BlockDevice describeBlockDevice(const string& name) {
+    string base = "/sys/block/" + name;
+    BlockDevice d;
+    d.name = name;
+    d.dev = readAttribute(base + "/dev");
+    d.model = readAttribute(base + "/device/model");
+    d.vendor = readAttribute(base + "/device/vendor");
+    d.serial = readAttribute(base + "/device/serial");
+    if (d.serial.empty()) d.serial = readAttribute(base + "/serial");
+    d.sizeBytes = readNumber(base + "/size") * 512; // Always 512-byte units
+    d.logicalBlockSize = (uint32_t)readNumber(base + "/queue/logical_block_size");
+    d.physicalBlockSize = (uint32_t)readNumber(base + "/queue/physical_block_size");
+    d.rotational = readAttribute(base + "/queue/rotational") == "1";
+    d.removable = readAttribute(base + "/removable") == "1";
+    d.readOnly = readAttribute(base + "/ro") == "1";
+    d.scheduler = activeScheduler(readAttribute(base + "/queue/scheduler"));
+    d.nrRequests = (uint32_t)readNumber(base + "/queue/nr_requests");
+    // A namespace's "device" link points at its controller (nvme0).
+    d.nvme = name.compare(0, 4, "nvme") == 0;
+    if (d.nvme) {
+        d.firmware = readAttribute(base + "/device/firmware_rev");
+        d.transport = readAttribute(base + "/device/transport");
+    }
+    d.dmName = readAttribute(base + "/dm/name");
+    d.holders = listDirectory(base + "/holders");
+    d.slaves = listDirectory(base + "/slaves");
+
+    // Partitions are subdirectories that carry a "partition" attribute.
+    for (const string& child : listDirectory(base)) {
+        string partBase = base + "/" + child;
+        struct stat st;
+        if (stat((partBase + "/partition").c_str(), &st) != 0) continue;
+        BlockPartition p;
+        p.name = child;
+        p.dev = readAttribute(partBase + "/dev");
+        p.startSector = readNumber(partBase + "/start");
+        p.sizeBytes = readNumber(partBase + "/size") * 512;
+        p.holders = listDirectory(partBase + "/holders");
+        d.partitions.push_back(p);
+    }
+    return d;
+}
+
+static vector<BlockDevice> resolveBlockDevices() {
+    vector<BlockDevice> devices;
+    for (const string& name : listDirectory("/sys/block")) {
+        BlockDevice d = describeBlockDevice(name);
+        if (d.sizeBytes == 0 && name.compare(0, 4, "loop") == 0) continue; // Unattached loop
+        devices.push_back(d);
+    }
+    return devices;
+}
+
+vector<BlockDevice> blockDevices() {
+    lock_guard<mutex> lock(blockMutex);
+    if (ueventFd == -2) ueventFd = openUeventSocket();
+    time_t now = time(nullptr);
+    if (ueventFd >= 0) {
+        if (drainUevents(ueventFd, "block")) cacheValid = false;
+    } else if (now - cachedAt >= kFallbackRefreshSeconds) {
+        cacheValid = false;
+    }
+    if (!cacheValid) {
+        cachedDevices = resolveBlockDevices();
+        cachedAt = now;
+        cacheValid = true;
+    }
+    return cachedDevices;
+}
+
+static void appendStringArray(ostringstream& json, const vector<string>& values) {
+    json << "[";
+    for (size_t i = 0; i < values.size(); i++) {
+        json << "\"" << jsonEscape(values[i]) << "\"" << (i < values.size() - 1 ? ", " : "");
+    }
+    json << "]";
+}
+
+vector<string> deviceMountPoints(const string& name, const string& dev, const vector<string>& holders,
+                                 const map<string, string>& devByName, const vector<MountEntry>& mounts) {
+    set<string> result;
+    auto collect = [&](const string& n, const string& d) {
+        for (const MountEntry& m : mounts) {
+            // btrfs and friends show an anonymous 0:N device; fall back to the source.
+            if ((!d.empty() && to_string(m.major) + ":" + to_string(m.minor) == d) || m.source == "/dev/" + n) {
+                result.insert(m.mountPoint);
+            }
+        }
+    };
+    collect(name, dev);
+    for (const string& holder : holders) {
+        auto it = devByName.find(holder);
+        collect(holder, it != devByName.end() ? it->second : "");
+    }
+    return vector<string>(result.begin(), result.end());
+}
+
+static string getBlockDevicesJSON_Internal() {
+    vector<BlockDevice> devices = blockDevices();
+    // Mounts change independently of devices, so they are matched per call.
+    vector<MountEntry> mounts = currentMounts();
+    map<string, string> devByName;
+    for (const BlockDevice& d : devices) devByName[d.name] = d.dev;
+
+    ostringstream json;
+    json << "{ \"block_devices\": [";
+    for (size_t i = 0; i < devices.size(); i++) {
+        const BlockDevice& d = devices[i];
+        json << "{";
+        json << "\"name\": \"" << jsonEscape(d.name) << "\", ";
+        json << "\"device\": \"" << d.dev << "\", ";
+        json << "\"model\": \"" << jsonEscape(d.model) << "\", ";
+        json << "\"vendor\": \"" << jsonEscape(d.vendor) << "\", ";
+        json << "\"serial\": \"" << jsonEscape(d.serial) << "\", ";
+        json << "\"size\": " << d.sizeBytes << ", ";
+        json << "\"logicalBlockSize\": " << d.logicalBlockSize << ", ";
+        json << "\"physicalBlockSize\": " << d.physicalBlockSize << ", ";
+        json << "\"isSSD\": " << (d.rotational ? "false" : "true") << ", ";
+        json << "\"removable\": " << (d.removable ? "true" : "false") << ", ";
+        json << "\"readOnly\": " << (d.readOnly ? "true" : "false") << ", ";
+        json << "\"scheduler\": \"" << jsonEscape(d.scheduler) << "\", ";
+        json << "\"nrRequests\": " << d.nrRequests << ", ";
+        json << "\"nvme\": " << (d.nvme ? "true" : "false") << ", ";
+        json << "\"firmware\": \"" << jsonEscape(d.firmware) << "\", ";
+        json << "\"transport\": \"" << jsonEscape(d.transport) << "\", ";
+        json << "\"dmName\": \"" << jsonEscape(d.dmName) << "\", ";
+        json << "\"holders\": ";
+        appendStringArray(json, d.holders);
+        json << ", \"slaves\": ";
+        appendStringArray(json, d.slaves);
+        json << ", \"mounts\": ";
+        appendStringArray(json, deviceMountPoints(d.name, d.dev, d.holders, devByName, mounts));
+        json << ", \"partitions\": [";
+        for (size_t p = 0; p < d.partitions.size(); p++) {
+            const BlockPartition& part = d.partitions[p];
+            json << "{";
+            json << "\"name\": \"" << jsonEscape(part.name) << "\", ";
+            json << "\"device\": \"" << part.dev << "\", ";
+            json << "\"startSector\": " << part.startSector << ", ";
+            json << "\"size\": " << part.sizeBytes << ", ";
+            json << "\"holders\": ";
+            appendStringArray(json, part.holders);
+            json << ", \"mounts\": ";
+            appendStringArray(json, deviceMountPoints(part.name, part.dev, part.holders, devByName, mounts));
+            json << "}";
+            if (p < d.partitions.size() - 1)
+                json << ", ";
+        }
+        json << "]}";
+        if (i < devices.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getBlockDevicesJSON() {
+    return strdup_cstr(getBlockDevicesJSON_Internal());
+}
@@ -0,0 +1,243 @@
+#include "include/connection_table.h"
+#include "include/open_files.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint32_t kAllStates = 0xfff;
+
+// TCP states as numbered in include/net/tcp_states.h.
+static const char* kStateNames[] = {
+    "UNKNOWN", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2",
+    "TIME_WAIT", "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING", "NEW_SYN_RECV"
+};
+static const int kStateCount = sizeof(kStateNames) / sizeof(kStateNames[0]);
+static const int kStateEstablished = 1;
+static const int kStateListen = 10;
+
+static const char* stateName(int state) {
+    return state >= 0 && state < kStateCount ? kStateNames[state] : "UNKNOWN";
+}
+
+static int stateNumber(const string& name) {
+    for (int i = 0; i < kStateCount; i++) {
+        if (name == kStateNames[i]) return i;
+    }
+    return 0;
+}
+
+// Sends one SOCK_DIAG_BY_FAMILY dump request and appends the replies.
+// Returns 0, or the errno of the failed send/receive or of the kernel's reply.
+static int dumpFamily(int fd, uint8_t family, uint32_t stateMask, vector<TcpConnection>& out) {
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq = family;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = IPPROTO_TCP;
+    request.req.idiag_states = stateMask;
+    request.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(fd, &request, sizeof(request), 0, (struct sockaddr*)&kernel, sizeof(kernel)) < 0) return errno;
+
+    // Large reads keep the syscall count low on dumps of 100k+ sockets.
+    vector<char> buf(256 * 1024);
+    char address[INET6_ADDRSTRLEN];
+    for (;;) {
+        ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (n == 0) return 0;
+        int len = (int)n;
+        for (struct nlmsghdr* nh = (struct nlmsghdr*)buf.data(); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == NLMSG_DONE) return 0;
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr* err = (const struct nlmsgerr*)NLMSG_DATA(nh);
+                return err->error ? -err->error : EPROTO;
+            }
+            if (nh->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+            const struct inet_diag_msg* msg = (const struct inet_diag_msg*)NLMSG_DATA(nh);
+
+            TcpConnection c;
+            c.family = msg->idiag_family == AF_INET6 ? 6 : 4;
+            c.state = msg->idiag_state;
+            inet_ntop(msg->idiag_family, msg->id.idiag_src, address, sizeof(address));
+            c.localAddress = address;
+            inet_ntop(msg->idiag_family, msg->id.idiag_dst, address, sizeof(address));
+            c.remoteAddress = address;
+            c.localPort = ntohs(msg->id.idiag_sport);
+            c.remotePort = ntohs(msg->id.idiag_dport);
+            c.inode = msg->idiag_inode;
+            c.uid = msg->idiag_uid;
+            c.receiveQueue = msg->idiag_rqueue;
+            c.sendQueue = msg->idiag_wqueue;
+            c.rttUs = c.rttVarUs = c.sendCwnd = c.retransmits = 0;
+
+            int attrLen = (int)(nh->nlmsg_len - NLMSG_LENGTH(sizeof(*msg)));
+            for (struct rtattr* attr = (struct rtattr*)(msg + 1); RTA_OK(attr, attrLen);
+                 attr = RTA_NEXT(attr, attrLen)) {
+                if (attr->rta_type != INET_DIAG_INFO) continue;
+                // Older kernels send a shorter struct; missing fields stay zero.
+                struct tcp_info info;
+                memset(&info, 0, sizeof(info));
+                memcpy(&info, RTA_DATA(attr), min((size_t)RTA_PAYLOAD(attr), sizeof(info)));
+                c.rttUs = info.tcpi_rtt;
+                c.rttVarUs = info.tcpi_rttvar;
+                c.sendCwnd = info.tcpi_snd_cwnd;
+                c.retransmits = info.tcpi_total_retrans;
+            }
+            out.push_back(std::move(c));
+        }
+    }
+}
+
+bool dumpTcpConnections(uint32_t stateMask, vector<TcpConnection>& out) {
+    out.clear();
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd < 0) return false;
+    uint32_t mask = stateMask ? stateMask : kAllStates;
+    int err = dumpFamily(fd, AF_INET, mask, out);
+    if (err == 0) {
+        // Without IPv6 support the kernel has no AF_INET6 handler and answers
+        // ENOENT: there are simply no IPv6 sockets, keep the IPv4 rows.
+        err = dumpFamily(fd, AF_INET6, mask, out);
+        if (err == ENOENT) err = 0;
+    }
+    close(fd);
+    return err == 0;
+}
+
+// The procfs fallback: same rows, no tcp_info.
+static void readProcConnections(uint32_t stateMask, vector<TcpConnection>& out) {
+    out.clear();
+    SocketTable table = readTcpSocketTable();
+    for (const auto& entry : table) {
+        const SocketEntry& s = entry.second;
+        TcpConnection c{};
+        c.family = s.protocol == "tcp6" ? 6 : 4;
+        c.state = stateNumber(s.state);
+        if (stateMask && !(stateMask & (1u << c.state))) continue;
+        c.localAddress = s.localAddress;
+        c.localPort = s.localPort;
+        c.remoteAddress = s.remoteAddress;
+        c.remotePort = s.remotePort;
+        c.inode = entry.first;
+        out.push_back(std::move(c));
+    }
+}
+
+// Listening sockets and inbound connections per local port.
+struct PortCounts {
+    int listening = 0;
+    int established = 0;
+};
+
+static string getConnectionTableJSON_Internal(int stateMask, int maxConnections) {
+    vector<TcpConnection> connections;
+    bool sockDiag = dumpTcpConnections((uint32_t)stateMask, connections);
+    if (!sockDiag) readProcConnections((uint32_t)stateMask, connections);
+
+    map<int, PortCounts> localPorts;
+    map<int, int> remotePorts;     // Outbound established connections per remote port
+    int stateCounts[kStateCount] = {0};
+    for (const TcpConnection& c : connections) {
+        if (c.state >= 0 && c.state < kStateCount) stateCounts[c.state]++;
+        if (c.state == kStateListen) localPorts[c.localPort].listening++;
+    }
+    for (const TcpConnection& c : connections) {
+        if (c.state != kStateEstablished) continue;
+        auto it = localPorts.find(c.localPort);
+        if (it != localPorts.end()) {
+            it->second.established++;
+        } else {
+            remotePorts[c.remotePort]++;
+        }
+    }
+
+    // Slowest connections first.
+    size_t limit = maxConnections > 0 ? min((size_t)maxConnections, connections.size()) : connections.size();
+    partial_sort(connections.begin(), connections.begin() + (long)limit, connections.end(),
+                 [](const TcpConnection& a, const TcpConnection& b) { return a.rttUs > b.rttUs; });
+
+    ostringstream json;
+    json << "{ \"source\": \"" << (sockDiag ? "sock_diag" : "procfs") << "\", ";
+    json << "\"total\": " << connections.size() << ", ";
+    json << "\"states\": {";
+    bool first = true;
+    for (int i = 1; i < kStateCount; i++) {
+        if (!stateCounts[i]) continue;
+        if (!first) json << ", ";
+        first = false;
+        json << "\"" << kStateNames[i] << "\": " << stateCounts[i];
+    }
+    json << "}, \"localPorts\": [";
+    first = true;
+    for (const auto& p : localPorts) {
+        if (!first) json << ", ";
+        first = false;
+        json << "{\"port\": " << p.first << ", \"listening\": " << p.second.listening
+             << ", \"established\": " << p.second.established << "}";
+    }
+    json << "], \"remotePorts\": [";
+    first = true;
+    for (const auto& p : remotePorts) {
+        if (!first) json << ", ";
+        first = false;
+        json << "{\"port\": " << p.first << ", \"established\": " << p.second << "}";
+    }
+    json << "], \"connections\": [";
+    for (size_t i = 0; i < limit; i++) {
+        const TcpConnection& c = connections[i];
+        json << "{";
+        json << "\"family\": " << c.family << ", ";
+        json << "\"state\": \"" << stateName(c.state) << "\", ";
+        json << "\"localAddress\": \"" << c.localAddress << "\", ";
+        json << "\"localPort\": " << c.localPort << ", ";
+        json << "\"remoteAddress\": \"" << c.remoteAddress << "\", ";
+        json << "\"remotePort\": " << c.remotePort << ", ";
+        json << "\"inode\": " << c.inode << ", ";
+        json << "\"uid\": " << c.uid << ", ";
+        json << "\"receiveQueue\": " << c.receiveQueue << ", ";
+        json << "\"sendQueue\": " << c.sendQueue << ", ";
+        json << "\"rttUs\": " << c.rttUs << ", ";
+        json << "\"rttVarUs\": " << c.rttVarUs << ", ";
+        json << "\"sendCwnd\": " << c.sendCwnd << ", ";
+        json << "\"retransmits\": " << c.retransmits;
+        json << "}";
+        if (i < limit - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getConnectionTableJSON(int stateMask, int maxConnections) {
+    return strdup_cstr(getConnectionTableJSON_Internal(stateMask, maxConnections));
+}
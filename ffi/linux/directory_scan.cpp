@@ -0,0 +1,579 @@
+#include "include/directory_scan.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint32_t kNoNode = 0xffffffffu;
+static const size_t kDirentBufferSize = 64 * 1024;
+static const size_t kLinkShards = 64;
+static const size_t kMaxChildrenPerNode = 100;
+
+// Layout returned by getdents64(2).
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// One directory. Children are an intrusive singly linked list and always
+// have a larger index than their parent.
+struct DirNode {
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint32_t nameLength;
+    uint64_t nameOffset;     // Into nodeNames
+    uint64_t ownBytes;       // Allocated bytes of the directory and its files
+    uint64_t ownApparent;    // Sum of st_size
+    uint32_t ownFiles;
+    bool unreadable;
+};
+
+// (dev, inode) of files with more than one link, sharded to keep workers
+// off a single lock.
+struct InodeKey {
+    uint64_t dev;
+    uint64_t inode;
+    bool operator==(const InodeKey& o) const { return dev == o.dev && inode == o.inode; }
+};
+struct InodeKeyHash {
+    size_t operator()(const InodeKey& k) const { return (size_t)(k.inode * 0x9E3779B97F4A7C15ULL ^ k.dev); }
+};
+struct LinkShard {
+    mutex m;
+    unordered_set<InodeKey, InodeKeyHash> seen;
+};
+
+// Open directory shared by its queued children, which open themselves with
+// openat() instead of resolving the full path again. Closed with the last one.
+struct DirHandle {
+    int fd;
+    explicit DirHandle(int f) : fd(f) {}
+    ~DirHandle() { close(fd); }
+};
+
+struct WorkItem {
+    uint32_t node;
+    shared_ptr<DirHandle> parent;  // Null for the scan root
+};
+
+struct WorkQueue {
+    mutex m;
+    deque<WorkItem> items;
+};
+
+// Files reported in the largest/stale lists. The path is rebuilt from the
+// directory node only when the results are rendered.
+struct FileRef {
+    uint64_t bytes;
+    uint32_t node;
+    string name;
+    int64_t accessTime;
+    int64_t modifyTime;
+    bool operator>(const FileRef& o) const { return bytes > o.bytes; }
+};
+
+// Log16 size buckets: <4K, <64K, <1M, <16M, <256M, <4G, >=4G.
+static const size_t kSizeBuckets = 7;
+static const char* kSizeBucketNames[kSizeBuckets] = {"<4K", "<64K", "<1M", "<16M", "<256M", "<4G", ">=4G"};
+
+struct ExtensionStats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t buckets[kSizeBuckets] = {0};
+};
+
+// Per-worker findings, merged only when results are requested, so the hot
+// path takes an uncontended lock.
+struct WorkerFindings {
+    mutex m;
+    vector<FileRef> largest;      // Min-heaps on size, at most topFileCount
+    vector<FileRef> stale;
+    unordered_map<string, ExtensionStats> extensions;
+};
+
+static const size_t kMaxExtensionLength = 16;
+static const size_t kMaxExtensionsPerWorker = 4096;
+
+static mutex nodeMutex;
+static vector<DirNode> nodes;
+static string nodeNames;
+static LinkShard linkShards[kLinkShards];
+static vector<unique_ptr<WorkQueue>> workQueues;
+static mutex findingsMutex;          // Guards the vector itself across restarts
+static vector<unique_ptr<WorkerFindings>> workerFindings;
+static size_t topFileCount = 0;
+static int64_t staleCutoff = 0;     // Seconds since epoch
+static int staleDaysSetting = 0;
+static dev_t scanDevice = 0;
+
+static atomic<bool> scanRunning(false);
+static atomic<bool> cancelRequested(false);
+static atomic<bool> scanCancelled(false);
+static atomic<int64_t> pendingDirectories(0);
+static atomic<uint64_t> filesScanned(0);
+static atomic<uint64_t> directoriesScanned(0);
+static atomic<uint64_t> bytesScanned(0);
+static atomic<uint64_t> errorCount(0);
+static atomic<uint64_t> skippedMounts(0);
+static atomic<uint64_t> scanStartNs(0);
+static atomic<uint64_t> scanEndNs(0);
+
+// Caller holds nodeMutex.
+static uint32_t addNode(uint32_t parent, const char* name, size_t length, uint64_t bytes) {
+    DirNode node{};
+    node.parent = parent;
+    node.firstChild = kNoNode;
+    node.nextSibling = kNoNode;
+    node.nameOffset = nodeNames.size();
+    node.nameLength = (uint32_t)length;
+    node.ownBytes = bytes;
+    nodeNames.append(name, length);
+    uint32_t index = (uint32_t)nodes.size();
+    if (parent != kNoNode) {
+        node.nextSibling = nodes[parent].firstChild;
+        nodes[parent].firstChild = index;
+    }
+    nodes.push_back(node);
+    return index;
+}
+
+// Caller holds nodeMutex.
+static string nodeName(uint32_t index) {
+    return nodeNames.substr(nodes[index].nameOffset, nodes[index].nameLength);
+}
+
+// Rebuilt from the parent chain; only needed to render results.
+static string nodePath(uint32_t index) {
+    lock_guard<mutex> lock(nodeMutex);
+    vector<uint32_t> chain;
+    for (uint32_t i = index; i != kNoNode; i = nodes[i].parent) chain.push_back(i);
+    string path = nodeName(chain.back());
+    for (size_t i = chain.size() - 1; i-- > 0;) {
+        if (path.back() != '/') path += '/';
+        path += nodeName(chain[i]);
+    }
+    return path;
+}
+
+// True the first time a multiply linked inode is seen.
+static bool firstLink(const struct stat& st) {
+    InodeKey key{(uint64_t)st.st_dev, (uint64_t)st.st_ino};
+    LinkShard& shard = linkShards[InodeKeyHash()(key) % kLinkShards];
+    lock_guard<mutex> lock(shard.m);
+    return shard.seen.insert(key).second;
+}
+
+// Lower-cased extension, "(none)" without one, "(other)" for long/odd ones.
+static string fileExtension(const char* name) {
+    const char* dot = strrchr(name, '.');
+    if (!dot || dot == name || dot[1] == '\0') return "(none)";
+    string ext;
+    for (const char* c = dot + 1; *c; c++) {
+        if (ext.size() == kMaxExtensionLength || (unsigned char)*c < 0x20) return "(other)";
+        ext += (char)tolower((unsigned char)*c);
+    }
+    return ext;
+}
+
+static void pushBounded(vector<FileRef>& heap, const FileRef& file) {
+    if (heap.size() < topFileCount) {
+        heap.push_back(file);
+        push_heap(heap.begin(), heap.end(), greater<FileRef>());
+    } else if (file.bytes > heap.front().bytes) {
+        pop_heap(heap.begin(), heap.end(), greater<FileRef>());
+        heap.back() = file;
+        push_heap(heap.begin(), heap.end(), greater<FileRef>());
+    }
+}
+
+static void recordFile(WorkerFindings& findings, uint32_t node, const char* name, const struct stat& st) {
+    uint64_t bytes = (uint64_t)st.st_blocks * 512;
+    size_t bucket = 0;  // By apparent size; allocation rounds everything up to 4K
+    for (uint64_t limit = 4096; bucket < kSizeBuckets - 1 && (uint64_t)st.st_size >= limit; limit <<= 4) bucket++;
+    string ext = fileExtension(name);
+
+    lock_guard<mutex> lock(findings.m);
+    auto it = findings.extensions.find(ext);
+    if (it == findings.extensions.end()) {
+        if (findings.extensions.size() >= kMaxExtensionsPerWorker) ext = "(other)";
+        it = findings.extensions.emplace(ext, ExtensionStats()).first;
+    }
+    it->second.files++;
+    it->second.bytes += bytes;
+    it->second.buckets[bucket]++;
+
+    if (topFileCount == 0) return;
+    bool isStale = staleCutoff > 0 && st.st_atime < staleCutoff && st.st_mtime < staleCutoff;
+    bool isLarge = findings.largest.size() < topFileCount || bytes > findings.largest.front().bytes;
+    bool staleCandidate = isStale && (findings.stale.size() < topFileCount || bytes > findings.stale.front().bytes);
+    if (!isLarge && !staleCandidate) return;
+    FileRef file{bytes, node, name, (int64_t)st.st_atime, (int64_t)st.st_mtime};
+    if (isLarge) pushBounded(findings.largest, file);
+    if (staleCandidate) pushBounded(findings.stale, file);
+}
+
+static void pushWork(size_t worker, uint32_t node, const shared_ptr<DirHandle>& parent) {
+    pendingDirectories++;
+    WorkQueue& q = *workQueues[worker];
+    lock_guard<mutex> lock(q.m);
+    q.items.push_back(WorkItem{node, parent});
+}
+
+// Owners take the newest item (depth first keeps queues short), thieves the
+// oldest, which tends to be the largest unexplored subtree.
+static bool takeWork(size_t worker, WorkItem& item) {
+    {
+        WorkQueue& q = *workQueues[worker];
+        lock_guard<mutex> lock(q.m);
+        if (!q.items.empty()) {
+            item = std::move(q.items.back());
+            q.items.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workQueues.size(); i++) {
+        WorkQueue& q = *workQueues[(worker + i) % workQueues.size()];
+        lock_guard<mutex> lock(q.m);
+        if (!q.items.empty()) {
+            item = std::move(q.items.front());
+            q.items.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Opens the directory relative to its parent, so the kernel resolves one
+// name instead of the whole path. The root node's name is the full path.
+static int openDirectory(const WorkItem& item) {
+    const int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+    lock_guard<mutex> lock(nodeMutex);
+    string name = nodeName(item.node);
+    return item.parent ? openat(item.parent->fd, name.c_str(), flags) : open(name.c_str(), flags);
+}
+
+static void scanDirectory(size_t worker, WorkItem item, char* buffer) {
+    const uint32_t node = item.node;
+    int fd = openDirectory(item);
+    item.parent.reset();
+    if (fd < 0) {
+        errorCount++;
+        lock_guard<mutex> lock(nodeMutex);
+        nodes[node].unreadable = true;
+        return;
+    }
+
+    auto handle = make_shared<DirHandle>(fd);  // Outlives this call while children are queued
+    WorkerFindings& findings = *workerFindings[worker];
+    uint64_t bytes = 0, apparent = 0, files = 0;
+    struct stat st;
+    long n = 0;
+    while (!cancelRequested && (n = syscall(SYS_getdents64, fd, buffer, kDirentBufferSize)) > 0) {
+        for (long offset = 0; offset < n;) {
+            const LinuxDirent64* d = (const LinuxDirent64*)(buffer + offset);
+            offset += d->d_reclen;
+            const char* name = d->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                errorCount++;
+                continue;
+            }
+            if (S_ISDIR(st.st_mode)) {
+                if (st.st_dev != scanDevice) {
+                    skippedMounts++;
+                    continue;
+                }
+                uint32_t child;
+                {
+                    lock_guard<mutex> lock(nodeMutex);
+                    child = addNode(node, name, strlen(name), (uint64_t)st.st_blocks * 512);
+                }
+                pushWork(worker, child, handle);
+                continue;
+            }
+            if (st.st_nlink > 1 && !firstLink(st)) continue;
+            bytes += (uint64_t)st.st_blocks * 512;
+            apparent += (uint64_t)st.st_size;
+            files++;
+            if (S_ISREG(st.st_mode)) recordFile(findings, node, name, st);
+        }
+    }
+    if (n < 0) errorCount++;
+
+    {
+        lock_guard<mutex> lock(nodeMutex);
+        nodes[node].ownBytes += bytes;
+        nodes[node].ownApparent += apparent;
+        nodes[node].ownFiles += (uint32_t)files;
+    }
+    filesScanned += files;
+    bytesScanned += bytes;
+    directoriesScanned++;
+}
+
+static void scanWorker(size_t worker) {
+    unique_ptr<char[]> buffer(new char[kDirentBufferSize]);
+    while (!cancelRequested) {
+        WorkItem item;
+        if (takeWork(worker, item)) {
+            scanDirectory(worker, std::move(item), buffer.get());
+            pendingDirectories--;
+        } else if (pendingDirectories == 0) {
+            return;
+        } else {
+            // Someone is still listing a directory that may yield more work.
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+    }
+}
+
+static void scanThread(size_t threads) {
+    vector<thread> workers;
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(scanWorker, i);
+    }
+    for (thread& t : workers) t.join();
+
+    scanCancelled = cancelRequested.load();
+    for (auto& q : workQueues) q->items.clear();
+    pendingDirectories = 0;
+    for (LinkShard& shard : linkShards) {
+        lock_guard<mutex> lock(shard.m);
+        unordered_set<InodeKey, InodeKeyHash>().swap(shard.seen);
+    }
+    scanEndNs = monotonicNanos();
+    scanRunning = false;
+}
+
+bool startDirectoryScan(const char* path, int threads, int topFiles, int staleDays) {
+    if (!path || !*path) return false;
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    bool expected = false;
+    if (!scanRunning.compare_exchange_strong(expected, true)) return false;
+
+    // Crawling is latency bound (metadata reads), so use more threads than cores.
+    size_t workerCount = threads > 0 ? (size_t)min(threads, 64)
+                                     : min<size_t>(16, max<size_t>(4, thread::hardware_concurrency()));
+    // Lock order is findingsMutex, then nodeMutex: rendering findings
+    // resolves node indexes, which must not be reset underneath it.
+    lock_guard<mutex> findingsLock(findingsMutex);
+    {
+        lock_guard<mutex> lock(nodeMutex);
+        vector<DirNode>().swap(nodes);
+        string().swap(nodeNames);
+        scanDevice = st.st_dev;
+        addNode(kNoNode, path, strlen(path), (uint64_t)st.st_blocks * 512);
+    }
+    workQueues.clear();
+    workerFindings.clear();
+    for (size_t i = 0; i < workerCount; i++) {
+        workQueues.emplace_back(new WorkQueue());
+        workerFindings.emplace_back(new WorkerFindings());
+    }
+    topFileCount = topFiles > 0 ? (size_t)min(topFiles, 10000) : 100;
+    staleDaysSetting = staleDays > 0 ? staleDays : 365;
+    staleCutoff = (int64_t)time(nullptr) - (int64_t)staleDaysSetting * 86400;
+    cancelRequested = false;
+    scanCancelled = false;
+    pendingDirectories = 0;
+    filesScanned = directoriesScanned = bytesScanned = errorCount = skippedMounts = 0;
+    scanStartNs = monotonicNanos();
+    scanEndNs = 0;
+    pushWork(0, 0, nullptr);
+    thread(scanThread, workerCount).detach();
+    return true;
+}
+
+void cancelDirectoryScan() {
+    cancelRequested = true;
+}
+
+struct NodeTotals {
+    uint64_t bytes;
+    uint64_t apparent;
+    uint64_t files;
+    uint64_t directories;
+};
+
+// Caller holds nodeMutex; `totals` holds cumulative values per node.
+static void appendNodeJSON(ostringstream& json, uint32_t index, int depth, const vector<NodeTotals>& totals) {
+    const DirNode& n = nodes[index];
+    const NodeTotals& t = totals[index];
+    json << "{";
+    json << "\"id\": " << index << ", ";
+    json << "\"name\": \"" << jsonEscape(nodeName(index)) << "\", ";
+    json << "\"size\": " << t.bytes << ", ";
+    json << "\"apparentSize\": " << t.apparent << ", ";
+    json << "\"files\": " << t.files << ", ";
+    json << "\"directories\": " << t.directories << ", ";
+    json << "\"ownFiles\": " << n.ownFiles << ", ";
+    json << "\"ownSize\": " << n.ownBytes << ", ";
+    json << "\"unreadable\": " << (n.unreadable ? "true" : "false");
+    if (depth > 0) {
+        vector<uint32_t> children;
+        for (uint32_t c = n.firstChild; c != kNoNode; c = nodes[c].nextSibling) children.push_back(c);
+        sort(children.begin(), children.end(),
+             [&](uint32_t a, uint32_t b) { return totals[a].bytes > totals[b].bytes; });
+        json << ", \"children\": [";
+        size_t shown = min(children.size(), kMaxChildrenPerNode);
+        for (size_t i = 0; i < shown; i++) {
+            if (i > 0) json << ", ";
+            appendNodeJSON(json, children[i], depth - 1, totals);
+        }
+        uint64_t otherBytes = 0;
+        for (size_t i = shown; i < children.size(); i++) otherBytes += totals[children[i]].bytes;
+        json << "], \"otherChildren\": " << (children.size() - shown) << ", ";
+        json << "\"otherChildrenSize\": " << otherBytes;
+    }
+    json << "}";
+}
+
+static string getDirectoryScanJSON_Internal(int nodeId, int depth) {
+    uint64_t endNs = scanEndNs;
+    uint64_t elapsedMs = scanStartNs ? ((endNs ? endNs : monotonicNanos()) - scanStartNs) / 1000000ULL : 0;
+    ostringstream json;
+    json << "{ \"running\": " << (scanRunning ? "true" : "false") << ", ";
+    json << "\"cancelled\": " << (scanCancelled ? "true" : "false") << ", ";
+    json << "\"elapsedMs\": " << elapsedMs << ", ";
+    json << "\"filesScanned\": " << filesScanned << ", ";
+    json << "\"directoriesScanned\": " << directoriesScanned << ", ";
+    json << "\"pendingDirectories\": " << max<int64_t>(0, pendingDirectories) << ", ";
+    json << "\"bytesScanned\": " << bytesScanned << ", ";
+    json << "\"errors\": " << errorCount << ", ";
+    json << "\"skippedMounts\": " << skippedMounts << ", ";
+    json << "\"tree\": ";
+
+    lock_guard<mutex> lock(nodeMutex);
+    if (nodeId < 0 || (size_t)nodeId >= nodes.size()) {
+        json << "null }";
+        return json.str();
+    }
+    // Children always follow their parent, so one reverse pass sums subtrees.
+    vector<NodeTotals> totals(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        NodeTotals& t = totals[i];
+        t.bytes += nodes[i].ownBytes;
+        t.apparent += nodes[i].ownApparent;
+        t.files += nodes[i].ownFiles;
+        if (nodes[i].parent != kNoNode) {
+            NodeTotals& p = totals[nodes[i].parent];
+            p.bytes += t.bytes;
+            p.apparent += t.apparent;
+            p.files += t.files;
+            p.directories += t.directories + 1;
+        }
+    }
+    appendNodeJSON(json, (uint32_t)nodeId, max(0, min(depth, 8)), totals);
+    json << " }";
+    return json.str();
+}
+
+char* getDirectoryScanJSON(int nodeId, int depth) {
+    return strdup_cstr(getDirectoryScanJSON_Internal(nodeId, depth));
+}
+
+static void appendFileListJSON(ostringstream& json, vector<FileRef>& files) {
+    sort(files.begin(), files.end(), greater<FileRef>());
+    if (files.size() > topFileCount) files.resize(topFileCount);
+    for (size_t i = 0; i < files.size(); i++) {
+        const FileRef& f = files[i];
+        string path = nodePath(f.node);
+        if (path.back() != '/') path += '/';
+        path += f.name;
+        json << "{";
+        json << "\"path\": \"" << jsonEscape(path) << "\", ";
+        json << "\"size\": " << f.bytes << ", ";
+        json << "\"accessTime\": " << f.accessTime << ", ";
+        json << "\"modifyTime\": " << f.modifyTime;
+        json << "}";
+        if (i < files.size() - 1)
+            json << ", ";
+    }
+}
+
+//
+// Merges the per-worker findings. Only `topFileCount` entries per worker
+// ever exist, so this is cheap even in the middle of a large crawl.
+//
+static string getDirectoryScanFindingsJSON_Internal() {
+    vector<FileRef> largest, stale;
+    unordered_map<string, ExtensionStats> extensions;
+    lock_guard<mutex> findingsLock(findingsMutex);
+    for (auto& w : workerFindings) {
+        lock_guard<mutex> lock(w->m);
+        largest.insert(largest.end(), w->largest.begin(), w->largest.end());
+        stale.insert(stale.end(), w->stale.begin(), w->stale.end());
+        for (const auto& e : w->extensions) {
+            ExtensionStats& total = extensions[e.first];
+            total.files += e.second.files;
+            total.bytes += e.second.bytes;
+            for (size_t b = 0; b < kSizeBuckets; b++) total.buckets[b] += e.second.buckets[b];
+        }
+    }
+    vector<pair<string, ExtensionStats>> byBytes(extensions.begin(), extensions.end());
+    sort(byBytes.begin(), byBytes.end(),
+         [](const pair<string, ExtensionStats>& a, const pair<string, ExtensionStats>& b) {
+             return a.second.bytes > b.second.bytes;
+         });
+
+    ostringstream json;
+    json << "{ \"running\": " << (scanRunning ? "true" : "false") << ", ";
+    json << "\"staleDays\": " << staleDaysSetting << ", ";
+    json << "\"largestFiles\": [";
+    appendFileListJSON(json, largest);
+    json << "], \"staleFiles\": [";
+    appendFileListJSON(json, stale);
+    json << "], \"sizeBuckets\": [";
+    for (size_t b = 0; b < kSizeBuckets; b++) {
+        json << "\"" << kSizeBucketNames[b] << "\"" << (b < kSizeBuckets - 1 ? ", " : "");
+    }
+    json << "], \"extensions\": [";
+    for (size_t i = 0; i < byBytes.size(); i++) {
+        const ExtensionStats& e = byBytes[i].second;
+        json << "{";
+        json << "\"extension\": \"" << jsonEscape(byBytes[i].first) << "\", ";
+        json << "\"files\": " << e.files << ", ";
+        json << "\"size\": " << e.bytes << ", ";
+        json << "\"histogram\": [";
+        for (size_t b = 0; b < kSizeBuckets; b++) {
+            json << e.buckets[b] << (b < kSizeBuckets - 1 ? ", " : "");
+        }
+        json << "]}";
+        if (i < byBytes.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getDirectoryScanFindingsJSON() {
+    return strdup_cstr(getDirectoryScanFindingsJSON_Internal());
+}
@@ -0,0 +1,250 @@
+#include "include/disk_activity.h"
+#include "include/latency_histogram.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+// Rolling window of intervals that saw I/O.
+static const size_t kLatencyWindow = 60;
+static const double kLatencyEwmaAlpha = 0.2;
+// A device is flagged when most recent busy intervals were slow yet idle.
+static const double kSlowLatencyMsSSD = 20.0;
+static const double kSlowLatencyMsRotational = 100.0;
+static const double kLowUtilization = 20.0;
+static const size_t kMinSlowIntervals = 5;
+
+// Raw counters of one /proc/diskstats line.
+struct DiskCounters {
+    uint64_t reads, sectorsRead, readMs;
+    uint64_t writes, sectorsWritten, writeMs;
+    uint64_t inFlight, ioTicks, weightedMs;
+};
+
+// Rolling state of one device across ticks.
+struct DeviceHistory {
+    bool rotational = false;
+    deque<double> latencies;        // Per-interval average latency, ms
+    deque<bool> suspect;            // Slow while lightly utilized
+    double ewma = 0.0;
+    bool ewmaValid = false;
+    LatencyHistogram depth;         // Instantaneous in-flight requests per tick
+};
+
+static mutex activityMutex;
+static map<string, DiskCounters> previousCounters;
+static uint64_t previousNs = 0;
+static vector<DiskActivity> latestActivity;
+static map<string, DeviceHistory> histories;
+// Whether a name is a whole device (/sys/block/<name> exists) rather than a partition.
+static unordered_map<string, bool> wholeDevice;
+
+// Caller holds activityMutex.
+static bool isWholeDevice(const string& name) {
+    auto it = wholeDevice.find(name);
+    if (it != wholeDevice.end()) return it->second;
+    bool whole = access(("/sys/block/" + name).c_str(), F_OK) == 0;
+    wholeDevice[name] = whole;
+    return whole;
+}
+
+// The time fields (read/write ms, io_ticks, time_in_queue) are printed as
+// unsigned int and wrap at 2^32 on every kernel.
+static uint64_t msDelta(uint64_t current, uint64_t previous) {
+    return (current - previous) & 0xffffffffULL;
+}
+
+// I/O and sector counts are unsigned long, 64-bit on 64-bit kernels, so a
+// drop means the device was reset (loop re-attached, USB replug, dm device
+// recreated) rather than wrapped. A 32-bit kernel's wrap looks the same and
+// just costs one tick.
+static bool countersReset(const DiskCounters& c, const DiskCounters& p) {
+    return c.reads < p.reads || c.writes < p.writes ||
+           c.sectorsRead < p.sectorsRead || c.sectorsWritten < p.sectorsWritten;
+}
+
+static DeviceHistory& historyFor(const string& name) {
+    auto it = histories.find(name);
+    if (it != histories.end()) return it->second;
+    DeviceHistory& h = histories[name];
+    string rotational;
+    h.rotational = readFile(("/sys/block/" + name + "/queue/rotational").c_str(), rotational) &&
+                   !rotational.empty() && rotational[0] == '1';
+    return h;
+}
+
+// Splits in-flight requests into reads and writes (blk-mq devices only).
+static bool readInflight(const string& name, uint64_t& reads, uint64_t& writes) {
+    string text;
+    unsigned long long r, w;
+    if (!readFile(("/sys/block/" + name + "/inflight").c_str(), text) ||
+        sscanf(text.c_str(), "%llu %llu", &r, &w) != 2) {
+        return false;
+    }
+    reads = r;
+    writes = w;
+    return true;
+}
+
+static double windowPercentile(const deque<double>& values, double q) {
+    if (values.empty()) return 0.0;
+    vector<double> sorted(values.begin(), values.end());
+    size_t index = min(sorted.size() - 1, (size_t)(q * (double)(sorted.size() - 1) + 0.5));
+    nth_element(sorted.begin(), sorted.begin() + (long)index, sorted.end());
+    return sorted[index];
+}
+
+// Caller holds activityMutex.
+static void updateHistory(DeviceHistory& h, DiskActivity& a, uint64_t ops, double latencyMs) {
+    if (ops > 0) {
+        h.ewma = h.ewmaValid ? h.ewma + kLatencyEwmaAlpha * (latencyMs - h.ewma) : latencyMs;
+        h.ewmaValid = true;
+        double slowMs = h.rotational ? kSlowLatencyMsRotational : kSlowLatencyMsSSD;
+        h.latencies.push_back(latencyMs);
+        h.suspect.push_back(latencyMs >= slowMs && a.utilization < kLowUtilization);
+        if (h.latencies.size() > kLatencyWindow) {
+            h.latencies.pop_front();
+            h.suspect.pop_front();
+        }
+    }
+    a.latencyEwmaMs = h.ewma;
+    a.latencyP50Ms = windowPercentile(h.latencies, 0.50);
+    a.latencyP95Ms = windowPercentile(h.latencies, 0.95);
+
+    // Throttled cloud volumes and dying disks look like this: requests take
+    // long, yet the device is mostly idle, so the time is spent elsewhere.
+    size_t slow = (size_t)count(h.suspect.begin(), h.suspect.end(), true);
+    a.slowDevice = slow >= kMinSlowIntervals && slow * 5 >= h.suspect.size() * 4;
+
+    a.depthP50 = h.depth.percentile(0.50);
+    a.depthP99 = h.depth.percentile(0.99);
+    a.depthMax = h.depth.max();
+}
+
+static void sampleDiskStats(uint64_t nowNs) {
+    string text;
+    if (!readFile("/proc/diskstats", text)) return;
+
+    lock_guard<mutex> lock(activityMutex);
+    map<string, DiskCounters> current;
+    istringstream iss(text);
+    string line;
+    char name[64];
+    while (getline(iss, line)) {
+        // major minor name reads merged sectors ms writes merged sectors ms in_flight io_ticks weighted ...
+        DiskCounters c;
+        unsigned long long f[11];
+        if (sscanf(line.c_str(), "%*u %*u %63s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   name, &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8], &f[9], &f[10]) != 12) {
+            continue;
+        }
+        c.reads = f[0]; c.sectorsRead = f[2]; c.readMs = f[3];
+        c.writes = f[4]; c.sectorsWritten = f[6]; c.writeMs = f[7];
+        c.inFlight = f[8]; c.ioTicks = f[9]; c.weightedMs = f[10];
+        // Partitions are already included in their disk; idle loop/ram devices are noise.
+        if (!isWholeDevice(name)) continue;
+        if ((strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0) && c.reads + c.writes == 0) continue;
+        current[name] = c;
+    }
+
+    const double elapsedSec = previousNs ? (double)(nowNs - previousNs) / 1e9 : 0.0;
+    vector<DiskActivity> activity;
+    for (const auto& entry : current) {
+        const DiskCounters& c = entry.second;
+        DeviceHistory& h = historyFor(entry.first);
+        DiskActivity a{};
+        a.device = entry.first;
+        a.inFlight = c.inFlight;
+        // Tried every tick: a failed read (e.g. mid re-add) only costs this sample its split.
+        bool split = readInflight(entry.first, a.inFlightReads, a.inFlightWrites);
+        if (!split) a.inFlightReads = a.inFlightWrites = 0;
+        h.depth.record(split ? a.inFlightReads + a.inFlightWrites : c.inFlight);
+
+        uint64_t ops = 0;
+        double latencyMs = 0.0;
+        auto prev = previousCounters.find(entry.first);
+        // After a reset this tick has no rates and adds no latency sample.
+        if (prev != previousCounters.end() && elapsedSec > 0 && !countersReset(c, prev->second)) {
+            const DiskCounters& p = prev->second;
+            uint64_t reads = c.reads - p.reads, writes = c.writes - p.writes;
+            uint64_t readMs = msDelta(c.readMs, p.readMs), writeMs = msDelta(c.writeMs, p.writeMs);
+            a.readBytesPerSec = (double)(c.sectorsRead - p.sectorsRead) * 512.0 / elapsedSec;
+            a.writeBytesPerSec = (double)(c.sectorsWritten - p.sectorsWritten) * 512.0 / elapsedSec;
+            a.readIops = (double)reads / elapsedSec;
+            a.writeIops = (double)writes / elapsedSec;
+            a.readLatencyMs = reads ? (double)readMs / (double)reads : 0.0;
+            a.writeLatencyMs = writes ? (double)writeMs / (double)writes : 0.0;
+            a.utilization = (double)msDelta(c.ioTicks, p.ioTicks) / (elapsedSec * 1000.0) * 100.0;
+            if (a.utilization > 100.0) a.utilization = 100.0;
+            a.averageQueueDepth = (double)msDelta(c.weightedMs, p.weightedMs) / (elapsedSec * 1000.0);
+            ops = reads + writes;
+            latencyMs = ops ? (double)(readMs + writeMs) / (double)ops : 0.0;
+        }
+        updateHistory(h, a, ops, latencyMs);
+        activity.push_back(a);
+    }
+    if (current.size() != previousCounters.size()) {
+        wholeDevice.clear(); // Devices came or went
+        for (auto it = histories.begin(); it != histories.end();) {
+            it = current.count(it->first) ? next(it) : histories.erase(it);
+        }
+    }
+    previousCounters.swap(current);
+    previousNs = nowNs;
+    latestActivity.swap(activity);
+}
+
+vector<DiskActivity> latestDiskActivity() {
+    registerSampler("diskstats", sampleDiskStats);
+    lock_guard<mutex> lock(activityMutex);
+    return latestActivity;
+}
+
+static string getDiskActivityJSON_Internal() {
+    vector<DiskActivity> activity = latestDiskActivity();
+    ostringstream json;
+    json << "{ \"disk_activity\": [";
+    for (size_t i = 0; i < activity.size(); i++) {
+        const DiskActivity& a = activity[i];
+        json << "{";
+        json << "\"device\": \"" << jsonEscape(a.device) << "\", ";
+        json << "\"readBytesPerSec\": " << a.readBytesPerSec << ", ";
+        json << "\"writeBytesPerSec\": " << a.writeBytesPerSec << ", ";
+        json << "\"readIops\": " << a.readIops << ", ";
+        json << "\"writeIops\": " << a.writeIops << ", ";
+        json << "\"readLatencyMs\": " << a.readLatencyMs << ", ";
+        json << "\"writeLatencyMs\": " << a.writeLatencyMs << ", ";
+        json << "\"utilization\": " << a.utilization << ", ";
+        json << "\"inFlight\": " << a.inFlight << ", ";
+        json << "\"inFlightReads\": " << a.inFlightReads << ", ";
+        json << "\"inFlightWrites\": " << a.inFlightWrites << ", ";
+        json << "\"averageQueueDepth\": " << a.averageQueueDepth << ", ";
+        json << "\"latencyEwmaMs\": " << a.latencyEwmaMs << ", ";
+        json << "\"latencyP50Ms\": " << a.latencyP50Ms << ", ";
+        json << "\"latencyP95Ms\": " << a.latencyP95Ms << ", ";
+        json << "\"queueDepth\": {\"p50\": " << a.depthP50 << ", \"p99\": " << a.depthP99
+             << ", \"max\": " << a.depthMax << "}, ";
+        json << "\"slowDevice\": " << (a.slowDevice ? "true" : "false");
+        json << "}";
+        if (i < activity.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getDiskActivityJSON() {
+    return strdup_cstr(getDiskActivityJSON_Internal());
+}
@@ -0,0 +1,343 @@
+#include "include/disk_benchmark.h"
+#include "include/latency_histogram.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// O_DIRECT needs buffers, offsets and sizes aligned to the logical block size.
+static const size_t kDirectAlignment = 4096;
+
+struct BenchmarkConfig {
+    string directory;
+    size_t seqBlock;
+    size_t randBlock;
+    int queueDepth;
+    uint64_t fileSize;
+    int durationMs;
+};
+
+struct TestResult {
+    bool ran = false;
+    double throughputMBps = 0.0;
+    double iops = 0.0;
+    uint64_t operations = 0;
+    // Latency percentiles in microseconds.
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;
+};
+
+struct BenchmarkResult {
+    string device;
+    BenchmarkConfig config;
+    bool direct = false;
+    bool cancelled = false;
+    string error;
+    time_t finishedAt = 0;
+    TestResult seqWrite, seqRead, randWrite, randRead;
+};
+
+enum class Phase { Idle, Layout, SeqWrite, SeqRead, RandWrite, RandRead };
+
+static mutex benchMutex;
+static map<string, BenchmarkResult> resultsByDevice;
+static atomic<bool> benchRunning(false);
+static atomic<bool> cancelRequested(false);
+static atomic<int> currentPhase((int)Phase::Idle);
+static atomic<int64_t> phaseStartedMs(0);
+static atomic<int> activeDurationMs(0);
+
+static int64_t monotonicMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Layout: return "layout";
+        case Phase::SeqWrite: return "seqWrite";
+        case Phase::SeqRead: return "seqRead";
+        case Phase::RandWrite: return "randWrite";
+        case Phase::RandRead: return "randRead";
+        default: return "idle";
+    }
+}
+
+static void* allocAligned(size_t size) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, kDirectAlignment, size) != 0) return nullptr;
+    // Incompressible data so compressing/deduplicating devices do real work.
+    uint64_t x = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uintptr_t)buffer;
+    uint64_t* words = (uint64_t*)buffer;
+    for (size_t i = 0; i < size / sizeof(uint64_t); i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        words[i] = x;
+    }
+    return buffer;
+}
+
+// Fills the file once so read tests hit allocated, written extents.
+static bool layoutFile(int fd, uint64_t fileSize) {
+    const size_t chunk = 4 << 20;
+    void* buffer = allocAligned(chunk);
+    if (!buffer) return false;
+    bool ok = true;
+    for (uint64_t off = 0; off < fileSize && !cancelRequested; off += chunk) {
+        size_t len = (size_t)min<uint64_t>(chunk, fileSize - off);
+        if (pwrite(fd, buffer, len, (off_t)off) != (ssize_t)len) {
+            ok = false;
+            break;
+        }
+    }
+    free(buffer);
+    return ok && fdatasync(fd) == 0;
+}
+
+//
+// Runs one test for `durationMs` with `queueDepth` workers issuing
+// synchronous I/O, so the device sees up to `queueDepth` requests in flight.
+//
+static TestResult runTest(int fd, const BenchmarkConfig& cfg, bool write, bool random) {
+    const size_t block = random ? cfg.randBlock : cfg.seqBlock;
+    const uint64_t blocks = cfg.fileSize / block;
+    if (blocks == 0) return TestResult(); // Block larger than the file: not run
+    atomic<uint64_t> nextBlock(0);
+    atomic<bool> failed(false);
+    vector<LatencyHistogram> histograms((size_t)cfg.queueDepth);
+    vector<uint64_t> ops((size_t)cfg.queueDepth, 0);
+
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + chrono::milliseconds(cfg.durationMs);
+    vector<thread> workers;
+    for (int w = 0; w < cfg.queueDepth; w++) {
+        workers.emplace_back([&, w]() {
+            void* buffer = allocAligned(block);
+            if (!buffer) {
+                failed = true;
+                return;
+            }
+            uint64_t rng = 0x2545F4914F6CDD1DULL * (uint64_t)(w + 1) ^ (uint64_t)time(nullptr);
+            LatencyHistogram& hist = histograms[(size_t)w];
+            while (!cancelRequested && chrono::steady_clock::now() < deadline) {
+                uint64_t index;
+                if (random) {
+                    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+                    index = rng % blocks;
+                } else {
+                    index = nextBlock.fetch_add(1) % blocks;
+                }
+                off_t offset = (off_t)(index * block);
+                auto t0 = chrono::steady_clock::now();
+                ssize_t n = write ? pwrite(fd, buffer, block, offset) : pread(fd, buffer, block, offset);
+                auto t1 = chrono::steady_clock::now();
+                if (n != (ssize_t)block) {
+                    failed = true;
+                    break;
+                }
+                hist.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+                ops[(size_t)w]++;
+            }
+            free(buffer);
+        });
+    }
+    for (thread& t : workers) t.join();
+    if (write) fdatasync(fd);
+    const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    TestResult result;
+    if (failed) return result;
+    LatencyHistogram merged;
+    for (const LatencyHistogram& h : histograms) merged.merge(h);
+    for (uint64_t n : ops) result.operations += n;
+    result.ran = true;
+    result.iops = elapsed > 0 ? (double)result.operations / elapsed : 0.0;
+    result.throughputMBps = result.iops * (double)block / 1e6;
+    result.p50 = (double)merged.percentile(0.50) / 1000.0;
+    result.p90 = (double)merged.percentile(0.90) / 1000.0;
+    result.p99 = (double)merged.percentile(0.99) / 1000.0;
+    result.p999 = (double)merged.percentile(0.999) / 1000.0;
+    result.max = (double)merged.max() / 1000.0;
+    return result;
+}
+
+static void enterPhase(Phase phase) {
+    currentPhase = (int)phase;
+    phaseStartedMs = monotonicMs();
+}
+
+static void benchmarkThread(BenchmarkConfig cfg, string device) {
+    BenchmarkResult result;
+    result.device = device;
+    result.config = cfg;
+
+    string path = cfg.directory + "/.system_info_benchmark.tmp";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_DIRECT | O_CLOEXEC, 0600);
+    result.direct = fd >= 0;
+    if (fd < 0 && errno == EINVAL) {
+        // tmpfs and some FUSE filesystems reject O_DIRECT; fall back to
+        // buffered I/O and drop the page cache before each read test.
+        unlink(path.c_str());
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        result.error = strerror(errno);
+    } else {
+        unlink(path.c_str()); // Nothing left behind even if the app dies mid-run
+        if (posix_fallocate(fd, 0, (off_t)cfg.fileSize) != 0 && ftruncate(fd, (off_t)cfg.fileSize) != 0) {
+            result.error = strerror(errno);
+        } else {
+            enterPhase(Phase::Layout);
+            if (!layoutFile(fd, cfg.fileSize)) {
+                result.error = cancelRequested ? "" : "layout write failed";
+            } else {
+                struct { Phase phase; bool write; bool random; TestResult* out; } tests[] = {
+                    {Phase::SeqWrite, true, false, &result.seqWrite},
+                    {Phase::SeqRead, false, false, &result.seqRead},
+                    {Phase::RandWrite, true, true, &result.randWrite},
+                    {Phase::RandRead, false, true, &result.randRead},
+                };
+                for (auto& test : tests) {
+                    if (cancelRequested) break;
+                    if (!test.write && !result.direct) {
+                        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                    }
+                    enterPhase(test.phase);
+                    *test.out = runTest(fd, cfg, test.write, test.random);
+                }
+            }
+        }
+        close(fd);
+    }
+    result.cancelled = cancelRequested;
+    result.finishedAt = time(nullptr);
+
+    {
+        lock_guard<mutex> lock(benchMutex);
+        // A cancelled run does not replace an earlier complete result.
+        auto it = resultsByDevice.find(device);
+        if (!result.cancelled || it == resultsByDevice.end()) {
+            resultsByDevice[device] = result;
+        }
+    }
+    currentPhase = (int)Phase::Idle;
+    benchRunning = false;
+}
+
+bool startDiskBenchmark(const char* directory, int seqBlockKB, int randBlockKB,
+                        int queueDepth, int fileSizeMB, int durationMs) {
+    if (!directory || !*directory) return false;
+    struct stat st;
+    if (stat(directory, &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    bool expected = false;
+    if (!benchRunning.compare_exchange_strong(expected, true)) return false;
+
+    // Block sizes are rounded up to the O_DIRECT alignment.
+    auto alignUp = [](size_t v) { return (v + kDirectAlignment - 1) / kDirectAlignment * kDirectAlignment; };
+    BenchmarkConfig cfg;
+    cfg.directory = directory;
+    cfg.seqBlock = alignUp(seqBlockKB > 0 ? (size_t)seqBlockKB * 1024 : 1 << 20);
+    cfg.randBlock = alignUp(randBlockKB > 0 ? (size_t)randBlockKB * 1024 : 4096);
+    cfg.queueDepth = queueDepth > 0 ? min(queueDepth, 256) : 4;
+    cfg.fileSize = (uint64_t)(fileSizeMB > 0 ? fileSizeMB : 256) << 20;
+    // At least one block of either size, or the random test has nowhere to go.
+    cfg.fileSize = max<uint64_t>(cfg.fileSize / cfg.seqBlock * cfg.seqBlock, max(cfg.seqBlock, cfg.randBlock));
+    cfg.durationMs = durationMs > 0 ? durationMs : 3000;
+
+    string device = blockDeviceName(st.st_dev, true);
+    if (device.empty()) device = cfg.directory; // Not block backed (tmpfs, NFS, ...)
+
+    cancelRequested = false;
+    activeDurationMs = cfg.durationMs;
+    thread(benchmarkThread, cfg, device).detach();
+    return true;
+}
+
+void cancelDiskBenchmark() {
+    cancelRequested = true;
+}
+
+bool cachedDiskSpeed(const string& device, double& readMBps, double& writeMBps) {
+    lock_guard<mutex> lock(benchMutex);
+    auto it = resultsByDevice.find(device);
+    if (it == resultsByDevice.end() || !it->second.seqRead.ran) return false;
+    readMBps = it->second.seqRead.throughputMBps;
+    writeMBps = it->second.seqWrite.throughputMBps;
+    return true;
+}
+
+static void appendTestJSON(ostringstream& json, const char* name, const TestResult& t) {
+    json << "\"" << name << "\": {";
+    json << "\"ran\": " << (t.ran ? "true" : "false") << ", ";
+    json << "\"throughput\": " << t.throughputMBps << ", ";
+    json << "\"iops\": " << t.iops << ", ";
+    json << "\"operations\": " << t.operations << ", ";
+    json << "\"latencyUs\": {\"p50\": " << t.p50 << ", \"p90\": " << t.p90
+         << ", \"p99\": " << t.p99 << ", \"p999\": " << t.p999 << ", \"max\": " << t.max << "}}";
+}
+
+static string getDiskBenchmarkJSON_Internal() {
+    ostringstream json;
+    Phase phase = (Phase)currentPhase.load();
+    double progress = 0.0;
+    if (phase != Phase::Idle && phase != Phase::Layout && activeDurationMs > 0) {
+        // Four timed phases of equal length.
+        double within = min(1.0, (double)(monotonicMs() - phaseStartedMs) / activeDurationMs);
+        progress = ((double)((int)phase - (int)Phase::SeqWrite) + within) / 4.0;
+    }
+    json << "{ \"running\": " << (benchRunning ? "true" : "false") << ", ";
+    json << "\"phase\": \"" << phaseName(phase) << "\", ";
+    json << "\"progress\": " << progress << ", ";
+    json << "\"results\": [";
+    lock_guard<mutex> lock(benchMutex);
+    bool first = true;
+    for (const auto& entry : resultsByDevice) {
+        const BenchmarkResult& r = entry.second;
+        if (!first) json << ", ";
+        first = false;
+        char stamp[64];
+        struct tm tm;
+        localtime_r(&r.finishedAt, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+        json << "{";
+        json << "\"device\": \"" << jsonEscape(r.device) << "\", ";
+        json << "\"directory\": \"" << jsonEscape(r.config.directory) << "\", ";
+        json << "\"direct\": " << (r.direct ? "true" : "false") << ", ";
+        json << "\"seqBlockSize\": " << r.config.seqBlock << ", ";
+        json << "\"randBlockSize\": " << r.config.randBlock << ", ";
+        json << "\"queueDepth\": " << r.config.queueDepth << ", ";
+        json << "\"fileSize\": " << r.config.fileSize << ", ";
+        json << "\"durationMs\": " << r.config.durationMs << ", ";
+        json << "\"finishedAt\": \"" << stamp << "\", ";
+        json << "\"cancelled\": " << (r.cancelled ? "true" : "false") << ", ";
+        json << "\"error\": \"" << jsonEscape(r.error) << "\", ";
+        appendTestJSON(json, "seqWrite", r.seqWrite);
+        json << ", ";
+        appendTestJSON(json, "seqRead", r.seqRead);
+        json << ", ";
+        appendTestJSON(json, "randWrite", r.randWrite);
+        json << ", ";
+        appendTestJSON(json, "randRead", r.randRead);
+        json << "}";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getDiskBenchmarkJSON() {
+    return strdup_cstr(getDiskBenchmarkJSON_Internal());
+}
@@ -0,0 +1,84 @@
+#include "include/disk_info.h"
+#include "include/block_devices.h"
+#include "include/disk_benchmark.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+using namespace std;
+
+// Get disk usage using statvfs
+static void getDiskUsage(double &totalGB, double &usedGB, double &freeGB) {
+    struct statvfs stat;
+    totalGB = usedGB = freeGB = 0.0;
+    if (statvfs("/", &stat) == 0) {
+        unsigned long long total_bytes = (unsigned long long)stat.f_blocks * stat.f_frsize;
+        unsigned long long free_bytes = (unsigned long long)stat.f_bfree * stat.f_frsize;
+        totalGB = total_bytes / 1e9;  // Convert to GB
+        freeGB = free_bytes / 1e9;
+        usedGB = totalGB - freeGB;
+    }
+}
+
+// Filesystem type of "/" from /proc/self/mounts.
+static string rootFileSystemType() {
+    string mounts;
+    if (!readFile("/proc/self/mounts", mounts)) return "Unknown";
+    istringstream iss(mounts);
+    string source, target, type, line;
+    string result = "Unknown";
+    while (getline(iss, line)) {
+        istringstream fields(line);
+        if (fields >> source >> target >> type && target == "/") {
+            result = type; // Last match wins for stacked mounts
+        }
+    }
+    return result;
+}
+
+// Main function to collect disk info
+static string getCompleteDiskInfo() {
+    double totalSpace = 0.0, usedSpace = 0.0, freeSpace = 0.0;
+    getDiskUsage(totalSpace, usedSpace, freeSpace);
+
+    string diskName = "Unknown";
+    bool isSSD = false;
+    struct stat st;
+    if (stat("/", &st) == 0) {
+        string device = blockDeviceName(st.st_dev, true);
+        if (!device.empty()) {
+            diskName = device;
+            for (const BlockDevice& d : blockDevices()) {
+                if (d.name == device) isSSD = !d.rotational;
+            }
+        }
+    }
+
+    // Speeds come from the last explicit benchmark of this device, never
+    // from a test run here.
+    double readSpeed = 0.0, writeSpeed = 0.0;
+    cachedDiskSpeed(diskName, readSpeed, writeSpeed);
+
+    // Construct JSON response
+    ostringstream oss;
+    oss << "{"
+        << "\"diskName\": \"" << jsonEscape(diskName) << "\","
+        << "\"fileSystemType\": \"" << jsonEscape(rootFileSystemType()) << "\","
+        << "\"totalSpace\": " << totalSpace << ","
+        << "\"usedSpace\": " << usedSpace << ","
+        << "\"freeSpace\": " << freeSpace << ","
+        << "\"readSpeed\": " << readSpeed << ","
+        << "\"writeSpeed\": " << writeSpeed << ","
+        << "\"isSSD\": " << (isSSD ? "true" : "false")
+        << "}";
+    return oss.str();
+}
+
+// Exposed FFI function
+char* getDiskInfo() {
+    return strdup_cstr(getCompleteDiskInfo());
+}
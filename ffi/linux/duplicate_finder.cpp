@@ -0,0 +1,418 @@
+#include "include/duplicate_finder.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const size_t kEdgeBytes = 64 * 1024;
+static const size_t kReadChunk = 1 << 20;
+
+enum class DupPhase { Idle, Listing, PartialHash, FullHash, Done, Cancelled };
+
+struct CandidateFile {
+    uint32_t directory;   // Index into the directory table
+    string name;
+    uint64_t size;
+    uint64_t hash;        // Partial, then full hash
+    bool failed;
+};
+
+struct DuplicateGroup {
+    uint64_t size;
+    vector<string> paths;
+    uint64_t reclaimable() const { return size * (paths.size() - 1); }
+};
+
+static mutex dupMutex;
+static vector<DuplicateGroup> duplicateGroups;
+static string dupError;
+static atomic<bool> dupRunning(false);
+static atomic<bool> dupCancel(false);
+static atomic<int> dupPhase((int)DupPhase::Idle);
+static atomic<uint64_t> filesListed(0);
+static atomic<uint64_t> filesToHash(0);
+static atomic<uint64_t> filesHashed(0);
+static atomic<uint64_t> bytesHashed(0);
+static atomic<uint64_t> dupStartNs(0);
+static atomic<uint64_t> dupEndNs(0);
+
+static const char* dupPhaseName(DupPhase phase) {
+    switch (phase) {
+        case DupPhase::Listing: return "listing";
+        case DupPhase::PartialHash: return "partialHash";
+        case DupPhase::FullHash: return "fullHash";
+        case DupPhase::Done: return "done";
+        case DupPhase::Cancelled: return "cancelled";
+        default: return "idle";
+    }
+}
+
+//
+// XXH64. Four independent 64-bit lanes per 32-byte stripe, so the compiler
+// can keep them in flight in parallel; several GB/s per core.
+//
+static const uint64_t kPrime1 = 11400714785074694791ULL;
+static const uint64_t kPrime2 = 14029467366897019727ULL;
+static const uint64_t kPrime3 = 1609587929392839161ULL;
+static const uint64_t kPrime4 = 9650029242287828579ULL;
+static const uint64_t kPrime5 = 2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static inline uint64_t read64(const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint32_t read32(const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t xxRound(uint64_t acc, uint64_t input) {
+    return rotl64(acc + input * kPrime2, 31) * kPrime1;
+}
+static inline uint64_t xxMerge(uint64_t acc, uint64_t val) {
+    return (acc ^ xxRound(0, val)) * kPrime1 + kPrime4;
+}
+
+class XXHash64 {
+public:
+    XXHash64() : v1(kPrime1 + kPrime2), v2(kPrime2), v3(0), v4(0 - kPrime1), total(0), buffered(0) {}
+
+    void update(const unsigned char* p, size_t len) {
+        total += len;
+        if (buffered) {
+            size_t take = min(len, sizeof(buffer) - buffered);
+            memcpy(buffer + buffered, p, take);
+            buffered += take;
+            p += take;
+            len -= take;
+            if (buffered < sizeof(buffer)) return;
+            stripe(buffer);
+            buffered = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32) stripe(p);
+        memcpy(buffer, p, len);
+        buffered = len;
+    }
+
+    uint64_t digest() const {
+        uint64_t h = total >= 32
+            ? xxMerge(xxMerge(xxMerge(xxMerge(rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18),
+                                              v1), v2), v3), v4)
+            : v3 + kPrime5;
+        h += total;
+        const unsigned char* p = buffer;
+        size_t len = buffered;
+        for (; len >= 8; p += 8, len -= 8) h = rotl64(h ^ xxRound(0, read64(p)), 27) * kPrime1 + kPrime4;
+        if (len >= 4) {
+            h = rotl64(h ^ (uint64_t)read32(p) * kPrime1, 23) * kPrime2 + kPrime3;
+            p += 4;
+            len -= 4;
+        }
+        for (; len > 0; p++, len--) h = rotl64(h ^ *p * kPrime5, 11) * kPrime1;
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    void stripe(const unsigned char* p) {
+        v1 = xxRound(v1, read64(p));
+        v2 = xxRound(v2, read64(p + 8));
+        v3 = xxRound(v3, read64(p + 16));
+        v4 = xxRound(v4, read64(p + 24));
+    }
+
+    uint64_t v1, v2, v3, v4;
+    uint64_t total;
+    unsigned char buffer[32];
+    size_t buffered;
+};
+
+static int openForHashing(const string& path) {
+    // O_NOATIME keeps the scan from making every file look recently used,
+    // but is only allowed on files we own.
+    int fd = open(path.c_str(), O_RDONLY | O_NOATIME | O_CLOEXEC);
+    if (fd < 0 && errno == EPERM) fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd;
+}
+
+static bool readFully(int fd, unsigned char* buf, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, offset);
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return true;
+}
+
+// Hash of the first and last kEdgeBytes (the whole file when it is smaller
+// than both together).
+static bool hashEdges(int fd, uint64_t size, unsigned char* buf, uint64_t& hash) {
+    XXHash64 h;
+    size_t head = (size_t)min<uint64_t>(size, kEdgeBytes);
+    if (!readFully(fd, buf, head, 0)) return false;
+    h.update(buf, head);
+    size_t tail = 0;
+    if (size > kEdgeBytes) {
+        uint64_t tailStart = max<uint64_t>(kEdgeBytes, size - kEdgeBytes);
+        tail = (size_t)(size - tailStart);
+        if (!readFully(fd, buf, tail, (off_t)tailStart)) return false;
+        h.update(buf, tail);
+    }
+    bytesHashed += head + tail;
+    hash = h.digest();
+    return true;
+}
+
+static bool hashWhole(int fd, uint64_t size, unsigned char* buf, uint64_t& hash) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    XXHash64 h;
+    uint64_t done = 0;
+    while (done < size && !dupCancel) {
+        ssize_t n = read(fd, buf, kReadChunk);
+        if (n <= 0) return false;
+        h.update(buf, (size_t)n);
+        done += (uint64_t)n;
+        bytesHashed += (uint64_t)n;
+    }
+    if (done != size) return false; // Changed or cancelled underneath us
+    hash = h.digest();
+    return true;
+}
+
+// Lists regular files on the filesystem of `root`, skipping extra hard links.
+static void listFiles(const string& root, uint64_t minSize, vector<string>& directories,
+                      vector<CandidateFile>& files) {
+    struct stat rootStat;
+    if (stat(root.c_str(), &rootStat) != 0) return;
+    set<pair<uint64_t, uint64_t>> linked;
+    directories.push_back(root);
+    vector<uint32_t> stack = {0};
+    struct stat st;
+    while (!stack.empty() && !dupCancel) {
+        uint32_t dirIndex = stack.back();
+        stack.pop_back();
+        int fd = open(directories[dirIndex].c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) continue;
+        DIR* dir = fdopendir(fd);
+        if (!dir) {
+            close(fd);
+            continue;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_DIR && entry->d_type != DT_REG) continue;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0 || st.st_dev != rootStat.st_dev) continue;
+            if (S_ISDIR(st.st_mode)) {
+                string path = directories[dirIndex];
+                if (path.back() != '/') path += '/';
+                directories.push_back(path + name);
+                stack.push_back((uint32_t)directories.size() - 1);
+                continue;
+            }
+            if (!S_ISREG(st.st_mode) || (uint64_t)st.st_size < minSize) continue;
+            // Hard links share their data; deleting one reclaims nothing.
+            if (st.st_nlink > 1 && !linked.emplace((uint64_t)st.st_dev, (uint64_t)st.st_ino).second) continue;
+            files.push_back(CandidateFile{dirIndex, name, (uint64_t)st.st_size, 0, false});
+            filesListed++;
+        }
+        closedir(dir);
+    }
+}
+
+// Hashes `indices` on `threads` workers, edges only or the whole file.
+static void hashFiles(vector<CandidateFile>& files, const vector<size_t>& indices,
+                      const vector<string>& directories, size_t threads, bool whole) {
+    // Anything a cancel leaves unhashed must not be grouped on a stale hash.
+    for (size_t i : indices) files[i].failed = true;
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            unique_ptr<unsigned char[]> buf(new unsigned char[max(kReadChunk, kEdgeBytes)]);
+            size_t i;
+            while (!dupCancel && (i = next.fetch_add(1)) < indices.size()) {
+                CandidateFile& f = files[indices[i]];
+                string path = directories[f.directory];
+                if (path.back() != '/') path += '/';
+                path += f.name;
+                int fd = openForHashing(path);
+                f.failed = fd < 0 || !(whole ? hashWhole(fd, f.size, buf.get(), f.hash)
+                                             : hashEdges(fd, f.size, buf.get(), f.hash));
+                if (fd >= 0) close(fd);
+                filesHashed++;
+            }
+        });
+    }
+    for (thread& w : workers) w.join();
+}
+
+// Splits `groups` into sub-groups of equal hash, keeping those with 2+ members.
+static vector<vector<size_t>> splitByHash(const vector<vector<size_t>>& groups, const vector<CandidateFile>& files) {
+    vector<vector<size_t>> result;
+    for (const auto& group : groups) {
+        unordered_map<uint64_t, vector<size_t>> byHash;
+        for (size_t i : group) {
+            if (!files[i].failed) byHash[files[i].hash].push_back(i);
+        }
+        for (auto& entry : byHash) {
+            if (entry.second.size() > 1) result.push_back(std::move(entry.second));
+        }
+    }
+    return result;
+}
+
+static void duplicateThread(string root, uint64_t minSize, size_t threads) {
+    vector<string> directories;
+    vector<CandidateFile> files;
+    dupPhase = (int)DupPhase::Listing;
+    listFiles(root, minSize, directories, files);
+
+    // Stage 1: equal sizes.
+    unordered_map<uint64_t, vector<size_t>> bySize;
+    for (size_t i = 0; i < files.size(); i++) bySize[files[i].size].push_back(i);
+    vector<vector<size_t>> groups;
+    vector<size_t> toHash;
+    for (auto& entry : bySize) {
+        if (entry.second.size() < 2) continue;
+        toHash.insert(toHash.end(), entry.second.begin(), entry.second.end());
+        groups.push_back(std::move(entry.second));
+    }
+    unordered_map<uint64_t, vector<size_t>>().swap(bySize);
+
+    // Stage 2: first and last 64 KiB.
+    dupPhase = (int)DupPhase::PartialHash;
+    filesToHash = toHash.size();
+    filesHashed = 0;
+    hashFiles(files, toHash, directories, threads, false);
+    groups = splitByHash(groups, files);
+
+    // Stage 3: full content, only where the edges did not cover the whole file.
+    dupPhase = (int)DupPhase::FullHash;
+    toHash.clear();
+    for (const auto& group : groups) {
+        if (files[group[0]].size > 2 * kEdgeBytes) toHash.insert(toHash.end(), group.begin(), group.end());
+    }
+    filesToHash = toHash.size();
+    filesHashed = 0;
+    hashFiles(files, toHash, directories, threads, true);
+    vector<vector<size_t>> small, large;
+    for (auto& group : groups) {
+        (files[group[0]].size > 2 * kEdgeBytes ? large : small).push_back(std::move(group));
+    }
+    large = splitByHash(large, files);
+    small.insert(small.end(), large.begin(), large.end());
+
+    // A partial run proves nothing about equality; report no groups at all.
+    if (dupCancel) small.clear();
+    vector<DuplicateGroup> result;
+    for (const auto& group : small) {
+        DuplicateGroup g;
+        g.size = files[group[0]].size;
+        for (size_t i : group) {
+            string path = directories[files[i].directory];
+            if (path.back() != '/') path += '/';
+            g.paths.push_back(path + files[i].name);
+        }
+        sort(g.paths.begin(), g.paths.end());
+        result.push_back(std::move(g));
+    }
+    sort(result.begin(), result.end(),
+         [](const DuplicateGroup& a, const DuplicateGroup& b) { return a.reclaimable() > b.reclaimable(); });
+
+    {
+        lock_guard<mutex> lock(dupMutex);
+        duplicateGroups.swap(result);
+        dupError = dupCancel ? "cancelled" : "";
+    }
+    dupPhase = (int)(dupCancel ? DupPhase::Cancelled : DupPhase::Done);
+    dupEndNs = monotonicNanos();
+    dupRunning = false;
+}
+
+bool startDuplicateScan(const char* path, int minSizeKB, int threads) {
+    if (!path || !*path) return false;
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    bool expected = false;
+    if (!dupRunning.compare_exchange_strong(expected, true)) return false;
+
+    size_t workerCount = threads > 0 ? (size_t)min(threads, 64)
+                                     : min<size_t>(8, max<size_t>(2, thread::hardware_concurrency()));
+    uint64_t minSize = minSizeKB > 0 ? (uint64_t)minSizeKB * 1024 : 1;
+    {
+        lock_guard<mutex> lock(dupMutex);
+        duplicateGroups.clear();
+        dupError.clear();
+    }
+    dupCancel = false;
+    filesListed = filesToHash = filesHashed = bytesHashed = 0;
+    dupStartNs = monotonicNanos();
+    dupEndNs = 0;
+    thread(duplicateThread, string(path), minSize, workerCount).detach();
+    return true;
+}
+
+void cancelDuplicateScan() {
+    dupCancel = true;
+}
+
+static string getDuplicateScanJSON_Internal(int maxGroups) {
+    size_t limit = maxGroups > 0 ? (size_t)maxGroups : 200;
+    uint64_t endNs = dupEndNs;
+    uint64_t elapsedMs = dupStartNs ? ((endNs ? endNs : monotonicNanos()) - dupStartNs) / 1000000ULL : 0;
+    ostringstream json;
+    json << "{ \"running\": " << (dupRunning ? "true" : "false") << ", ";
+    json << "\"phase\": \"" << dupPhaseName((DupPhase)dupPhase.load()) << "\", ";
+    json << "\"elapsedMs\": " << elapsedMs << ", ";
+    json << "\"filesListed\": " << filesListed << ", ";
+    json << "\"filesToHash\": " << filesToHash << ", ";
+    json << "\"filesHashed\": " << filesHashed << ", ";
+    json << "\"bytesHashed\": " << bytesHashed << ", ";
+
+    lock_guard<mutex> lock(dupMutex);
+    uint64_t reclaimable = 0;
+    for (const DuplicateGroup& g : duplicateGroups) reclaimable += g.reclaimable();
+    json << "\"error\": \"" << jsonEscape(dupError) << "\", ";
+    json << "\"groupCount\": " << duplicateGroups.size() << ", ";
+    json << "\"reclaimableBytes\": " << reclaimable << ", ";
+    json << "\"groups\": [";
+    size_t shown = min(limit, duplicateGroups.size());
+    for (size_t i = 0; i < shown; i++) {
+        const DuplicateGroup& g = duplicateGroups[i];
+        json << "{\"size\": " << g.size << ", ";
+        json << "\"reclaimableBytes\": " << g.reclaimable() << ", ";
+        json << "\"paths\": [";
+        for (size_t p = 0; p < g.paths.size(); p++) {
+            json << "\"" << jsonEscape(g.paths[p]) << "\"" << (p < g.paths.size() - 1 ? ", " : "");
+        }
+        json << "]}";
+        if (i < shown - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getDuplicateScanJSON(int maxGroups) {
+    return strdup_cstr(getDuplicateScanJSON_Internal(maxGroups));
+}
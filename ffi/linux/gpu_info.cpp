@@ -0,0 +1,200 @@
+#include "include/gpu_info.h"
+#include "include/gpu_sampler.h"
+#include "include/pci_ids.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Single-line sysfs attribute without the trailing newline.
+static string readAttribute(const string& path) {
+    string value;
+    if (!readFile(path.c_str(), value)) return "";
+    size_t end = value.find_last_not_of(" \n\t");
+    return end == string::npos ? "" : value.substr(0, end + 1);
+}
+
+static uint16_t readHexId(const string& path) {
+    return (uint16_t)strtoul(readAttribute(path).c_str(), nullptr, 16);
+}
+
+static string linkBasename(const string& path) {
+    char target[4096];
+    ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+    if (len <= 0) return "";
+    target[len] = '\0';
+    const char* slash = strrchr(target, '/');
+    return slash ? slash + 1 : target;
+}
+
+// Clock of the "*" (current) line of an amdgpu pp_dpm_* table, in MHz.
+static double currentDpmClock(const string& path) {
+    string text;
+    if (!readFile(path.c_str(), text)) return 0.0;
+    size_t star = text.find('*');
+    if (star == string::npos) return 0.0;
+    size_t lineStart = text.rfind('\n', star);
+    const char* colon = strchr(text.c_str() + (lineStart == string::npos ? 0 : lineStart + 1), ':');
+    return colon ? strtod(colon + 1, nullptr) : 0.0;
+}
+
+vector<GpuDevice> enumerateGpus() {
+    const string root = currentGpuSysfsRoot();
+    const string pciDir = root + "/bus/pci/devices";
+    vector<GpuDevice> gpus;
+    DIR* dir = opendir(pciDir.c_str());
+    if (!dir) return gpus;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        string base = pciDir + "/" + entry->d_name;
+        if (readAttribute(base + "/class").compare(0, 4, "0x03") != 0) continue;
+
+        GpuDevice g;
+        g.pciSlot = entry->d_name;
+        g.vendorId = readHexId(base + "/vendor");
+        g.deviceId = readHexId(base + "/device");
+        g.subsystemVendorId = readHexId(base + "/subsystem_vendor");
+        g.subsystemDeviceId = readHexId(base + "/subsystem_device");
+        pciVendorName(g.vendorId, g.vendorName);
+        pciDeviceName(g.vendorId, g.deviceId, g.deviceName);
+        g.driver = linkBasename(base + "/driver");
+        if (!g.driver.empty()) g.driverVersion = readAttribute(root + "/module/" + g.driver + "/version");
+        g.bootVga = readAttribute(base + "/boot_vga") == "1";
+        g.linkSpeed = readAttribute(base + "/current_link_speed");
+        g.linkWidth = atoi(readAttribute(base + "/current_link_width").c_str());
+        g.maxLinkSpeed = readAttribute(base + "/max_link_speed");
+        g.maxLinkWidth = atoi(readAttribute(base + "/max_link_width").c_str());
+        g.vramTotal = strtoull(readAttribute(base + "/mem_info_vram_total").c_str(), nullptr, 10);
+
+        DIR* drm = opendir((base + "/drm").c_str());
+        if (drm) {
+            struct dirent* d;
+            while ((d = readdir(drm)) != nullptr) {
+                if (strncmp(d->d_name, "card", 4) == 0 && !strchr(d->d_name, '-')) g.card = d->d_name;
+            }
+            closedir(drm);
+        }
+        // Integrated GPUs sit on the root bus (Intel 00:02.0) or, for AMD
+        // APUs, only get a small BIOS carve-out as "VRAM".
+        g.integrated = g.pciSlot.compare(5, 3, "00:") == 0 ||
+                       (g.driver == "amdgpu" && g.vramTotal > 0 && g.vramTotal <= (1ULL << 30));
+        gpus.push_back(g);
+    }
+    closedir(dir);
+    // Boot GPU first, then discrete before integrated.
+    sort(gpus.begin(), gpus.end(), [](const GpuDevice& a, const GpuDevice& b) {
+        if (a.bootVga != b.bootVga) return a.bootVga;
+        if (a.integrated != b.integrated) return !a.integrated;
+        return a.pciSlot < b.pciSlot;
+    });
+    return gpus;
+}
+
+// Latest sampler values for the card at `pciSlot`.
+static bool latestSample(const string& pciSlot, GpuSample& sample) {
+    for (const GpuCardState& state : gpuCardStates(1)) {
+        if (state.pciSlot == pciSlot && !state.history.empty()) {
+            sample = state.history.back();
+            return true;
+        }
+    }
+    return false;
+}
+
+static string extract_gpu_info() {
+    vector<GpuDevice> gpus = enumerateGpus();
+    string gpuName = "";
+    string vendor = "";
+    double memorySize = 0.0;         // in GB
+    double coreClockSpeed = 0.0;
+    double memoryClockSpeed = 0.0;
+    double temperature = 0.0;
+    double usagePercentage = 0.0;
+    double vramUsage = 0.0;          // in GB
+    string driverVersion = "";
+    bool isIntegrated = false;
+
+    if (!gpus.empty()) {
+        const GpuDevice& g = gpus.front();
+        gpuName = !g.deviceName.empty() ? g.deviceName : g.driver;
+        vendor = g.vendorName;
+        memorySize = (double)g.vramTotal / (1024.0 * 1024.0 * 1024.0);
+        driverVersion = !g.driverVersion.empty() ? g.driverVersion : g.driver;
+        isIntegrated = g.integrated;
+        memoryClockSpeed = currentDpmClock(currentGpuSysfsRoot() + "/bus/pci/devices/" + g.pciSlot + "/pp_dpm_mclk");
+        GpuSample sample;
+        if (latestSample(g.pciSlot, sample)) {
+            usagePercentage = sample.busyPercent;
+            coreClockSpeed = sample.frequencyMHz;
+            temperature = sample.temperatureC;
+            vramUsage = (double)sample.vramUsed / (1024.0 * 1024.0 * 1024.0);
+        }
+    }
+
+    // --- Build JSON output ---
+    ostringstream json;
+    json << "{\n";
+    json << "  \"gpuName\": \"" << jsonEscape(gpuName) << "\",\n";
+    json << "  \"vendor\": \"" << jsonEscape(vendor) << "\",\n";
+    json << "  \"memorySize\": " << fixed << setprecision(2) << memorySize << ",\n";
+    json << "  \"coreClockSpeed\": " << fixed << setprecision(2) << coreClockSpeed << ",\n";
+    json << "  \"memoryClockSpeed\": " << fixed << setprecision(2) << memoryClockSpeed << ",\n";
+    json << "  \"temperature\": " << fixed << setprecision(2) << temperature << ",\n";
+    json << "  \"usagePercentage\": " << fixed << setprecision(2) << usagePercentage << ",\n";
+    json << "  \"vramUsage\": " << fixed << setprecision(2) << vramUsage << ",\n";
+    json << "  \"driverVersion\": \"" << jsonEscape(driverVersion) << "\",\n";
+    json << "  \"isIntegrated\": " << (isIntegrated ? "true" : "false") << "\n";
+    json << "}";
+    return json.str();
+}
+
+static string getGpuDevicesJSON_Internal() {
+    vector<GpuDevice> gpus = enumerateGpus();
+    ostringstream json;
+    json << "{ \"gpu_devices\": [";
+    for (size_t i = 0; i < gpus.size(); i++) {
+        const GpuDevice& g = gpus[i];
+        char ids[48];
+        snprintf(ids, sizeof(ids), "%04x:%04x %04x:%04x", g.vendorId, g.deviceId,
+                 g.subsystemVendorId, g.subsystemDeviceId);
+        json << "{";
+        json << "\"pciSlot\": \"" << jsonEscape(g.pciSlot) << "\", ";
+        json << "\"pciIds\": \"" << ids << "\", ";
+        json << "\"vendor\": \"" << jsonEscape(g.vendorName) << "\", ";
+        json << "\"name\": \"" << jsonEscape(g.deviceName) << "\", ";
+        json << "\"driver\": \"" << jsonEscape(g.driver) << "\", ";
+        json << "\"driverVersion\": \"" << jsonEscape(g.driverVersion) << "\", ";
+        json << "\"card\": \"" << jsonEscape(g.card) << "\", ";
+        json << "\"bootVga\": " << (g.bootVga ? "true" : "false") << ", ";
+        json << "\"isIntegrated\": " << (g.integrated ? "true" : "false") << ", ";
+        json << "\"linkSpeed\": \"" << jsonEscape(g.linkSpeed) << "\", ";
+        json << "\"linkWidth\": " << g.linkWidth << ", ";
+        json << "\"maxLinkSpeed\": \"" << jsonEscape(g.maxLinkSpeed) << "\", ";
+        json << "\"maxLinkWidth\": " << g.maxLinkWidth << ", ";
+        json << "\"vramTotal\": " << g.vramTotal;
+        json << "}";
+        if (i < gpus.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+// FFI-Compatible Wrappers.
+char* getGPUInfo() {
+    return strdup_cstr(extract_gpu_info());
+}
+
+char* getGpuDevicesJSON() {
+    return strdup_cstr(getGpuDevicesJSON_Internal());
+}
@@ -0,0 +1,286 @@
+#include "include/gpu_sampler.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const size_t kGpuRingCapacity = 300;
+
+// One engine busy counter: a percentage file, or an idle residency counter
+// in ms whose growth over the interval is the idle share.
+struct GpuEngine {
+    string name;
+    string path;
+    bool idleResidency = false;
+    uint64_t lastIdleMs = 0;
+    uint64_t lastNs = 0;
+};
+
+// Paths and rolling state of one DRM card.
+struct GpuCard {
+    string card;
+    string device;           // <root>/class/drm/cardN/device
+    string driver;
+    string pciSlot;
+    string hwmonTemp;        // temp1_input in millidegrees
+    vector<GpuEngine> engines;  // At most kMaxGpuEngines
+    vector<GpuSample> ring;  // Preallocated to kGpuRingCapacity
+    size_t next = 0;
+    size_t count = 0;
+};
+
+static mutex gpuMutex;
+static string sysfsRoot = "/sys";
+static vector<GpuCard> gpuCards;
+static bool cardsEnumerated = false;
+
+static bool readUnsigned(const string& path, uint64_t& value) {
+    string text;
+    if (!readFile(path.c_str(), text) || text.empty() || text[0] < '0' || text[0] > '9') return false;
+    value = strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+static string linkBasename(const string& path) {
+    char target[4096];
+    ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+    if (len <= 0) return "";
+    target[len] = '\0';
+    const char* slash = strrchr(target, '/');
+    return slash ? slash + 1 : target;
+}
+
+// Current engine clock: the "*" line of amdgpu's pp_dpm_sclk, or i915's
+// actual frequency.
+static double readFrequencyMHz(const GpuCard& card) {
+    string text;
+    if (readFile((card.device + "/pp_dpm_sclk").c_str(), text)) {
+        size_t star = text.find('*');
+        if (star != string::npos) {
+            size_t lineStart = text.rfind('\n', star);
+            const char* p = text.c_str() + (lineStart == string::npos ? 0 : lineStart + 1);
+            const char* colon = strchr(p, ':');
+            if (colon) return strtod(colon + 1, nullptr);
+        }
+    }
+    uint64_t mhz;
+    if (readUnsigned(sysfsRoot + "/class/drm/" + card.card + "/gt_act_freq_mhz", mhz)) return (double)mhz;
+    return 0.0;
+}
+
+static vector<string> subdirectories(const string& path, const char* prefix) {
+    vector<string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return names;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) names.push_back(entry->d_name);
+    }
+    closedir(dir);
+    sort(names.begin(), names.end());
+    return names;
+}
+
+static void addEngine(GpuCard& card, const string& name, const string& path, bool idleResidency) {
+    if (card.engines.size() == kMaxGpuEngines || access(path.c_str(), R_OK) != 0) return;
+    GpuEngine engine;
+    engine.name = name;
+    engine.path = path;
+    engine.idleResidency = idleResidency;
+    card.engines.push_back(engine);
+}
+
+// amdgpu reports gfx busy directly. i915 has RC6 residency per GT under
+// gt/gtN (the legacy file covers the whole GPU), xe a gtidle counter per GT.
+static void enumerateEngines(GpuCard& card, const string& cardPath) {
+    addEngine(card, "gfx", card.device + "/gpu_busy_percent", false);
+    for (const string& gt : subdirectories(cardPath + "/gt", "gt")) {
+        addEngine(card, gt, cardPath + "/gt/" + gt + "/rc6_residency_ms", true);
+    }
+    if (card.engines.empty()) addEngine(card, "gt", cardPath + "/power/rc6_residency_ms", true);
+    for (const string& tile : subdirectories(card.device, "tile")) {
+        for (const string& gt : subdirectories(card.device + "/" + tile, "gt")) {
+            string gtidle = card.device + "/" + tile + "/" + gt + "/gtidle";
+            string name;
+            if (readFile((gtidle + "/name").c_str(), name)) {
+                name.erase(name.find_last_not_of(" \n") + 1);
+            }
+            addEngine(card, name.empty() ? gt : name, gtidle + "/idle_residency_ms", true);
+        }
+    }
+}
+
+// Caller holds gpuMutex.
+static void enumerateCards() {
+    gpuCards.clear();
+    string drm = sysfsRoot + "/class/drm";
+    DIR* dir = opendir(drm.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            // cardN only; cardN-DP-1 and friends are connectors.
+            const char* name = entry->d_name;
+            if (strncmp(name, "card", 4) != 0 || name[4] == '\0' || strchr(name, '-')) continue;
+            GpuCard card;
+            card.card = name;
+            card.device = drm + "/" + name + "/device";
+            card.driver = linkBasename(card.device + "/driver");
+            card.pciSlot = linkBasename(card.device);
+            enumerateEngines(card, drm + "/" + name);
+            DIR* hwmon = opendir((card.device + "/hwmon").c_str());
+            if (hwmon) {
+                struct dirent* h;
+                while ((h = readdir(hwmon)) != nullptr) {
+                    if (strncmp(h->d_name, "hwmon", 5) == 0) {
+                        card.hwmonTemp = card.device + "/hwmon/" + h->d_name + "/temp1_input";
+                        break;
+                    }
+                }
+                closedir(hwmon);
+            }
+            card.ring.resize(kGpuRingCapacity);
+            gpuCards.push_back(std::move(card));
+        }
+        closedir(dir);
+    }
+    sort(gpuCards.begin(), gpuCards.end(),
+         [](const GpuCard& a, const GpuCard& b) { return a.card < b.card; });
+    cardsEnumerated = true;
+}
+
+static void sampleGpus(uint64_t nowNs) {
+    lock_guard<mutex> lock(gpuMutex);
+    if (!cardsEnumerated) enumerateCards();
+    for (GpuCard& card : gpuCards) {
+        GpuSample s{};
+        s.timestampNs = nowNs;
+        uint64_t value;
+        for (size_t i = 0; i < card.engines.size(); i++) {
+            GpuEngine& e = card.engines[i];
+            if (!readUnsigned(e.path, value)) continue;
+            if (!e.idleResidency) {
+                s.engineBusyPercent[i] = (double)value;
+                continue;
+            }
+            // Busy is whatever part of the interval the GT was not idle.
+            if (e.lastNs && nowNs > e.lastNs && value >= e.lastIdleMs) {
+                double idleMs = (double)(value - e.lastIdleMs);
+                double elapsedMs = (double)(nowNs - e.lastNs) / 1e6;
+                s.engineBusyPercent[i] = max(0.0, min(100.0, 100.0 - idleMs * 100.0 / elapsedMs));
+            }
+            e.lastIdleMs = value;
+            e.lastNs = nowNs;
+        }
+        for (size_t i = 0; i < card.engines.size(); i++) s.busyPercent = max(s.busyPercent, s.engineBusyPercent[i]);
+        if (readUnsigned(card.device + "/mem_busy_percent", value)) s.memoryBusyPercent = (double)value;
+        if (readUnsigned(card.device + "/mem_info_vram_used", value)) s.vramUsed = value;
+        if (readUnsigned(card.device + "/mem_info_vram_total", value)) s.vramTotal = value;
+        if (!card.hwmonTemp.empty() && readUnsigned(card.hwmonTemp, value)) s.temperatureC = (double)value / 1000.0;
+        s.frequencyMHz = readFrequencyMHz(card);
+
+        card.ring[card.next] = s;
+        card.next = (card.next + 1) % kGpuRingCapacity;
+        if (card.count < kGpuRingCapacity) card.count++;
+    }
+}
+
+static void ensureGpuSampler() {
+    registerSampler("gpu", sampleGpus);
+}
+
+void setGpuSysfsRoot(const char* root) {
+    lock_guard<mutex> lock(gpuMutex);
+    sysfsRoot = root && *root ? root : "/sys";
+    cardsEnumerated = false;
+    gpuCards.clear();
+}
+
+string currentGpuSysfsRoot() {
+    lock_guard<mutex> lock(gpuMutex);
+    return sysfsRoot;
+}
+
+double getGPUUsage() {
+    ensureGpuSampler();
+    lock_guard<mutex> lock(gpuMutex);
+    double busiest = 0.0;
+    for (const GpuCard& card : gpuCards) {
+        if (card.count == 0) continue;
+        const GpuSample& last = card.ring[(card.next + kGpuRingCapacity - 1) % kGpuRingCapacity];
+        busiest = max(busiest, last.busyPercent);
+    }
+    return busiest;
+}
+
+vector<GpuCardState> gpuCardStates(size_t maxSamples) {
+    ensureGpuSampler();
+    lock_guard<mutex> lock(gpuMutex);
+    vector<GpuCardState> states;
+    for (const GpuCard& card : gpuCards) {
+        GpuCardState state;
+        state.card = card.card;
+        state.driver = card.driver;
+        state.pciSlot = card.pciSlot;
+        for (const GpuEngine& e : card.engines) state.engines.push_back(e.name);
+        size_t n = min(maxSamples, card.count);
+        for (size_t i = n; i > 0; i--) {
+            state.history.push_back(card.ring[(card.next + kGpuRingCapacity - i) % kGpuRingCapacity]);
+        }
+        states.push_back(std::move(state));
+    }
+    return states;
+}
+
+static string getGpuSamplesJSON_Internal(int maxSamples) {
+    vector<GpuCardState> states = gpuCardStates(maxSamples > 0 ? (size_t)maxSamples : 1);
+    ostringstream json;
+    json << "{ \"gpus\": [";
+    for (size_t i = 0; i < states.size(); i++) {
+        const GpuCardState& c = states[i];
+        json << "{";
+        json << "\"card\": \"" << jsonEscape(c.card) << "\", ";
+        json << "\"driver\": \"" << jsonEscape(c.driver) << "\", ";
+        json << "\"pciSlot\": \"" << jsonEscape(c.pciSlot) << "\", ";
+        json << "\"engines\": [";
+        for (size_t e = 0; e < c.engines.size(); e++) {
+            json << "\"" << jsonEscape(c.engines[e]) << "\"" << (e < c.engines.size() - 1 ? ", " : "");
+        }
+        json << "], \"samples\": [";
+        for (size_t s = 0; s < c.history.size(); s++) {
+            const GpuSample& g = c.history[s];
+            json << "{\"t\": " << g.timestampNs / 1000000ULL << ", ";
+            json << "\"busy\": " << g.busyPercent << ", ";
+            json << "\"engineBusy\": [";
+            for (size_t e = 0; e < c.engines.size(); e++) {
+                json << g.engineBusyPercent[e] << (e < c.engines.size() - 1 ? ", " : "");
+            }
+            json << "], ";
+            json << "\"memoryBusy\": " << g.memoryBusyPercent << ", ";
+            json << "\"vramUsed\": " << g.vramUsed << ", ";
+            json << "\"vramTotal\": " << g.vramTotal << ", ";
+            json << "\"frequencyMHz\": " << g.frequencyMHz << ", ";
+            json << "\"temperature\": " << g.temperatureC << "}";
+            if (s < c.history.size() - 1)
+                json << ", ";
+        }
+        json << "]}";
+        if (i < states.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getGpuSamplesJSON(int maxSamples) {
+    return strdup_cstr(getGpuSamplesJSON_Internal(maxSamples));
+}
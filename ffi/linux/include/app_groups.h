@@ -0,0 +1,9 @@
+#ifndef APP_GROUPS_H
+#define APP_GROUPS_H
+
+// Folds the running processes into applications using cgroup app scopes
+// (app-*.scope / app-*.service), the process tree, executable paths and
+// .desktop Exec lines, and reports per-application CPU, memory and I/O.
+char* getApplicationGroupsJSON();
+
+#endif // APP_GROUPS_H
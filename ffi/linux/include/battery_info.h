@@ -0,0 +1,46 @@
+#ifndef BATTERY_INFO_H
+#define BATTERY_INFO_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// One battery from /sys/class/power_supply/<name>/uevent. Energy values are
+// in µWh; batteries that only report charge (µAh) are converted with the
+// design voltage so every battery can be summed.
+struct BatteryReading {
+    std::string name;            // "BAT0"
+    std::string status;          // Charging, Discharging, Full, Not charging
+    std::string technology;      // "Li-ion", "Li-poly", ...
+    std::string manufacturer;
+    std::string model;
+    int capacityPercent;         // POWER_SUPPLY_CAPACITY, -1 if missing
+    uint64_t energyNow;
+    uint64_t energyFull;
+    uint64_t energyFullDesign;
+    uint64_t chargeFull;         // µAh, 0 for energy-only batteries
+    uint64_t chargeFullDesign;
+    uint64_t powerNow;           // µW, always positive
+    uint64_t voltageNow;         // µV
+    uint64_t voltageMinDesign;
+    int cycleCount;              // -1 if the firmware does not report it
+    double temperatureC;         // 0 if missing
+};
+
+struct PowerSupplySnapshot {
+    std::vector<BatteryReading> batteries;
+    bool acOnline;
+    uint64_t acChangedNs;        // CLOCK_MONOTONIC of the last AC change, 0 if none
+};
+
+// Reads the batteries' uevent files. The supply list and AC state are
+// rescanned only after a power_supply uevent (or a lost one).
+PowerSupplySnapshot readPowerSupplies();
+
+// For testing against a fake tree; defaults to "/sys".
+void setPowerSupplyRoot(const char* root);
+
+// Standard C++ function declaration (no extern "C" here)
+char* getBatteryInfo();
+
+#endif // BATTERY_INFO_H
@@ -0,0 +1,45 @@
+#ifndef BATTERY_MODEL_H
+#define BATTERY_MODEL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+
+// A contiguous stretch of charging or discharging.
+struct ChargeSession {
+    bool charging;
+    time_t start;
+    time_t end;              // 0 while the session is still open
+    double startPercent;
+    double endPercent;
+    double energyWh;         // Energy moved in or out of the batteries
+    double averageWatts;
+};
+
+// Smoothed power model fed by the shared sampler. Times are in minutes and
+// -1 when not applicable (e.g. time to empty while charging).
+struct BatteryEstimate {
+    std::string state;       // "Charging", "Discharging" or "Idle"
+    double percent;
+    double instantWatts;
+    double ewmaWatts;
+    double stddevWatts;
+    double minutesToEmpty;
+    double minutesToEmptyLow;    // 95% band
+    double minutesToEmptyHigh;
+    double minutesToFull;
+    double minutesToFullLow;
+    double minutesToFullHigh;
+    uint64_t samples;        // Since the state last changed
+    std::vector<ChargeSession> sessions;  // Oldest first
+};
+
+BatteryEstimate batteryEstimate();
+
+// Smoothing time constant of the discharge-rate EWMA (5..3600 s, default 120 s).
+void setBatteryModelTimeConstant(int seconds);
+
+char* getBatteryModelJSON();
+
+#endif // BATTERY_MODEL_H
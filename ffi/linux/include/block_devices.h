@@ -0,0 +1,56 @@
+#ifndef BLOCK_DEVICES_H
+#define BLOCK_DEVICES_H
+
+#include "mount_table.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct BlockPartition {
+    std::string name;
+    std::string dev;          // "major:minor"
+    uint64_t startSector;
+    uint64_t sizeBytes;
+    std::vector<std::string> holders;
+};
+
+// Disk descriptor assembled from /sys/block/<name>.
+struct BlockDevice {
+    std::string name;
+    std::string dev;          // "major:minor"
+    std::string model;
+    std::string vendor;
+    std::string serial;
+    uint64_t sizeBytes;
+    uint32_t logicalBlockSize;
+    uint32_t physicalBlockSize;
+    bool rotational;
+    bool removable;
+    bool readOnly;
+    std::string scheduler;    // Active one, e.g. "mq-deadline"
+    uint32_t nrRequests;
+    bool nvme;
+    std::string firmware;     // NVMe controller attributes
+    std::string transport;
+    std::string dmName;       // Device-mapper name (LVM "vg-lv", crypt, ...)
+    std::vector<BlockPartition> partitions;
+    std::vector<std::string> holders;  // Stacked devices on the whole disk
+    std::vector<std::string> slaves;   // Devices a dm/md device is built on
+};
+
+// Descriptors of every block device. Resolved once and cached until a
+// block uevent arrives.
+std::vector<BlockDevice> blockDevices();
+
+// Mount points of device `name` ("major:minor" `dev`), directly or through
+// the devices stacked on it (`holders`, resolved with `devByName`). Mounts
+// with an anonymous 0:N device (btrfs, ...) are matched by their source.
+std::vector<std::string> deviceMountPoints(const std::string& name, const std::string& dev,
+                                           const std::vector<std::string>& holders,
+                                           const std::map<std::string, std::string>& devByName,
+                                           const std::vector<MountEntry>& mounts);
+
+char* getBlockDevicesJSON();
+
+#endif // BLOCK_DEVICES_H
@@ -0,0 +1,37 @@
+#ifndef CONNECTION_TABLE_H
+#define CONNECTION_TABLE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// TCP sockets from NETLINK_SOCK_DIAG (inet_diag) dumps. The kernel applies
+// the state filter and returns binary records with tcp_info attached, so
+// there is no /proc/net/tcp text to format or parse.
+struct TcpConnection {
+    int family;              // 4 or 6
+    int state;               // TCP_ESTABLISHED, TCP_LISTEN, ... (include/net/tcp_states.h)
+    std::string localAddress;
+    int localPort;
+    std::string remoteAddress;
+    int remotePort;
+    uint64_t inode;          // Matches socket:[inode] in /proc/[pid]/fd
+    uint32_t uid;
+    uint32_t receiveQueue;   // Backlog for listeners
+    uint32_t sendQueue;
+    uint32_t rttUs;          // tcp_info, 0 when not available
+    uint32_t rttVarUs;
+    uint32_t sendCwnd;
+    uint32_t retransmits;    // tcpi_total_retrans
+};
+
+// Dumps IPv4 and IPv6 TCP sockets whose state bit (1 << state) is set in
+// `stateMask` (0 = all). Returns false if sock_diag is unavailable; a
+// kernel without IPv6 just yields no IPv6 rows.
+bool dumpTcpConnections(uint32_t stateMask, std::vector<TcpConnection>& out);
+
+// Connections with per-port listen/established counts. Falls back to
+// /proc/net/tcp (without tcp_info) when sock_diag is unavailable.
+char* getConnectionTableJSON(int stateMask, int maxConnections);
+
+#endif // CONNECTION_TABLE_H
@@ -0,0 +1,27 @@
+#ifndef DIRECTORY_SCAN_H
+#define DIRECTORY_SCAN_H
+
+// ncdu-style disk usage analyzer. A background crawl walks a directory tree
+// on a work-stealing thread pool, stays on the starting filesystem and
+// counts hard-linked files once. Only directories are kept in memory (files
+// are folded into their parent), so millions of files stay cheap.
+
+// Starts a crawl of `path` with `threads` workers (<= 0 picks a default).
+// The same pass keeps the `topFiles` largest files (default 100), the
+// largest files neither accessed nor modified for `staleDays` (default 365)
+// and a size histogram per extension.
+// Returns false if a crawl is already running or `path` is not a directory.
+bool startDirectoryScan(const char* path, int threads, int topFiles, int staleDays);
+
+// Requests cancellation; the partial tree stays available.
+void cancelDirectoryScan();
+
+// Progress counters plus the subtree under directory `nodeId` (0 is the
+// root) down to `depth` levels, children sorted by size. Safe to call while
+// the crawl is running.
+char* getDirectoryScanJSON(int nodeId, int depth);
+
+// Largest files, stale files and the per-extension histogram so far.
+char* getDirectoryScanFindingsJSON();
+
+#endif // DIRECTORY_SCAN_H
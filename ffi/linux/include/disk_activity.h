@@ -0,0 +1,37 @@
+#ifndef DISK_ACTIVITY_H
+#define DISK_ACTIVITY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Per-device activity derived from /proc/diskstats deltas on the shared
+// sampling cadence, with rolling latency and queue depth statistics.
+struct DiskActivity {
+    std::string device;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    double readIops;
+    double writeIops;
+    double readLatencyMs;    // Average time per completed read in the interval
+    double writeLatencyMs;
+    double utilization;      // % of the interval with I/O in flight (io_ticks)
+    uint64_t inFlight;       // Requests in flight at the last sample
+    uint64_t inFlightReads;  // From /sys/block/<dev>/inflight when present
+    uint64_t inFlightWrites;
+    double averageQueueDepth;     // Time-weighted depth over the interval (iostat aqu-sz)
+    double latencyEwmaMs;         // Rolling estimates over recent intervals with I/O
+    double latencyP50Ms;
+    double latencyP95Ms;
+    uint64_t depthP50;            // Queue depth distribution since sampling began
+    uint64_t depthP99;
+    uint64_t depthMax;
+    bool slowDevice;   // Latency stays high while utilization is low
+};
+
+// Latest computed values; never blocks on a new sample.
+std::vector<DiskActivity> latestDiskActivity();
+
+char* getDiskActivityJSON();
+
+#endif // DISK_ACTIVITY_H
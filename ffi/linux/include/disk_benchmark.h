@@ -0,0 +1,25 @@
+#ifndef DISK_BENCHMARK_H
+#define DISK_BENCHMARK_H
+
+#include <string>
+
+// Storage benchmark engine (sequential/random read/write with O_DIRECT).
+// Runs only when explicitly started, on a background thread; results are
+// cached per block device.
+
+// Starts a run against a scratch file in `directory`. Values <= 0 select the
+// defaults (1 MiB sequential blocks, 4 KiB random blocks, queue depth 4,
+// 256 MiB file, 3 s per test). Returns false if a run is already active.
+bool startDiskBenchmark(const char* directory, int seqBlockKB, int randBlockKB,
+                        int queueDepth, int fileSizeMB, int durationMs);
+
+// Requests cancellation of the active run.
+void cancelDiskBenchmark();
+
+// Progress of the active run plus every cached result.
+char* getDiskBenchmarkJSON();
+
+// Cached {read, write} sequential throughput in MB/s for a block device, if any.
+bool cachedDiskSpeed(const std::string& device, double& readMBps, double& writeMBps);
+
+#endif // DISK_BENCHMARK_H
@@ -0,0 +1,7 @@
+#ifndef DISK_INFO_H
+#define DISK_INFO_H
+
+// Standard C++ function declarations
+char* getDiskInfo();
+
+#endif // DISK_INFO_H
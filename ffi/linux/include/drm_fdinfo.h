@@ -0,0 +1,24 @@
+#ifndef DRM_FDINFO_H
+#define DRM_FDINFO_H
+
+#include <string>
+#include <map>
+#include <cstdint>
+
+// GPU usage counters of one DRM client, from /proc/[pid]/fdinfo/[fd]
+// (Documentation/gpu/drm-usage-stats.rst). Several fds, even in different
+// processes, can refer to the same client; drm-client-id tells them apart.
+struct DrmClientUsage {
+    std::string driver;                          // drm-driver
+    std::string pdev;                            // drm-pdev (PCI slot)
+    uint64_t clientId = 0;                       // drm-client-id
+    std::map<std::string, uint64_t> engineNs;    // drm-engine-<engine>: busy ns
+    std::map<std::string, uint64_t> cycles;      // drm-cycles-<engine>
+    std::map<std::string, uint64_t> totalCycles; // drm-total-cycles-<engine>
+    uint64_t memoryKB = 0;   // Resident memory over all regions
+};
+
+// Parses one fdinfo file. Returns false when it is not a DRM client.
+bool parseDrmFdinfo(const std::string& text, DrmClientUsage& out);
+
+#endif // DRM_FDINFO_H
@@ -0,0 +1,19 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+// Duplicate file finder. Candidates are narrowed in stages so most files are
+// never read: equal size, then a hash of the first and last 64 KiB, then a
+// full-content hash of whatever still collides. Runs on a background thread.
+
+// Starts a search below `path` (one filesystem, regular files of at least
+// `minSizeKB`, default 1 byte) with `threads` hashing workers (<= 0 picks a
+// default). Returns false if a search is already running.
+bool startDuplicateScan(const char* path, int minSizeKB, int threads);
+
+// Requests cancellation of the active search.
+void cancelDuplicateScan();
+
+// Progress and the `maxGroups` (<= 0: 200) groups with the most reclaimable bytes.
+char* getDuplicateScanJSON(int maxGroups);
+
+#endif // DUPLICATE_FINDER_H
@@ -0,0 +1,12 @@
+// free_cstr.h
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+__attribute__((visibility("default"))) void free_cstr(char* ptr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef GPU_INFO_H
+#define GPU_INFO_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Display controller (PCI class 0x03xxxx) from /sys/bus/pci/devices.
+struct GpuDevice {
+    std::string pciSlot;         // "0000:03:00.0"
+    uint16_t vendorId;
+    uint16_t deviceId;
+    uint16_t subsystemVendorId;
+    uint16_t subsystemDeviceId;
+    std::string vendorName;      // From pci.ids, empty if unknown
+    std::string deviceName;
+    std::string driver;
+    std::string driverVersion;   // Module version, if the module has one
+    std::string card;            // DRM card ("card0"), empty without a DRM driver
+    bool bootVga;                // Firmware console GPU
+    bool integrated;
+    std::string linkSpeed;       // "16.0 GT/s PCIe"
+    int linkWidth;
+    std::string maxLinkSpeed;
+    int maxLinkWidth;
+    uint64_t vramTotal;          // Bytes, 0 when not reported
+};
+
+std::vector<GpuDevice> enumerateGpus();
+
+// Primary GPU in the same JSON shape as the macOS implementation.
+char* getGPUInfo();
+
+// Every display controller with PCIe link and driver details.
+char* getGpuDevicesJSON();
+
+#endif // GPU_INFO_H
@@ -0,0 +1,48 @@
+#ifndef GPU_SAMPLER_H
+#define GPU_SAMPLER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Background GPU sampler over /sys/class/drm/card*/device. Each tick of the
+// shared sampler appends one sample per card to a fixed ring, so readers
+// never wait for a measurement interval.
+
+// Engines tracked per card: amdgpu's gfx, and one per Intel GT (render and,
+// on newer parts, media) from its idle residency counter.
+static const size_t kMaxGpuEngines = 4;
+
+struct GpuSample {
+    uint64_t timestampNs;    // CLOCK_MONOTONIC
+    double busyPercent;      // gpu_busy_percent, or the busiest engine
+    double engineBusyPercent[kMaxGpuEngines];   // Indexed like GpuCardState::engines
+    double memoryBusyPercent;
+    uint64_t vramUsed;       // Bytes
+    uint64_t vramTotal;
+    double frequencyMHz;
+    double temperatureC;
+};
+
+struct GpuCardState {
+    std::string card;        // "card0"
+    std::string driver;      // "amdgpu", "i915", ...
+    std::string pciSlot;     // "0000:03:00.0"
+    std::vector<std::string> engines;  // "gfx", "gt0", "gt1-mc", ...
+    std::vector<GpuSample> history;   // Oldest first
+};
+
+// Changes the sysfs mount point (default "/sys"), e.g. to a fake tree in
+// tests. Cards are re-enumerated and histories cleared.
+void setGpuSysfsRoot(const char* root);
+std::string currentGpuSysfsRoot();
+
+// Busy percentage of the busiest card at the last tick; 0 without a GPU.
+double getGPUUsage();
+
+// Snapshot of every card with at most `maxSamples` recent samples.
+std::vector<GpuCardState> gpuCardStates(size_t maxSamples);
+
+char* getGpuSamplesJSON(int maxSamples);
+
+#endif // GPU_SAMPLER_H
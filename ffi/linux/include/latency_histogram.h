@@ -0,0 +1,75 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+
+// Log-linear (HDR style) histogram: each power of two is split into 16
+// linear sub-buckets, which keeps the relative error under ~6% from 1 up to
+// 2^50 while staying a fixed 6 KB array that can be merged by addition.
+class LatencyHistogram {
+public:
+    static const int kSubBits = 4;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kBuckets = 48 * kSubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(counts_, 0, sizeof(counts_));
+        total_ = 0;
+        max_ = 0;
+    }
+
+    void record(uint64_t value) {
+        counts_[indexOf(value)]++;
+        total_++;
+        if (value > max_) max_ = value;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < kBuckets; i++) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+
+    // Value at quantile q (0..1), reported as the upper edge of its bucket.
+    uint64_t percentile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = (uint64_t)(q * (double)(total_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                uint64_t upper = upperEdge(i);
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+private:
+    static int indexOf(uint64_t value) {
+        if (value < (uint64_t)kSubBuckets) return (int)value;
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBits;
+        int index = (shift + 1) * kSubBuckets + (int)((value >> shift) & (kSubBuckets - 1));
+        return index < kBuckets ? index : kBuckets - 1;
+    }
+
+    static uint64_t upperEdge(int index) {
+        if (index < kSubBuckets) return (uint64_t)index;
+        int shift = index / kSubBuckets - 1;
+        uint64_t sub = (uint64_t)(index % kSubBuckets) | (uint64_t)kSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    uint64_t counts_[kBuckets];
+    uint64_t total_;
+    uint64_t max_;
+};
+
+#endif // LATENCY_HISTOGRAM_H
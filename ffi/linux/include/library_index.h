@@ -0,0 +1,11 @@
+#ifndef LIBRARY_INDEX_H
+#define LIBRARY_INDEX_H
+
+// Inverted index of file-backed mappings across processes:
+// (dev, inode, path) -> pids mapping it, with aggregated mapped size.
+
+// Brings the index up to date (maps of new processes are added, exited ones
+// removed) and returns every mapping whose path starts with `pathPrefix`.
+char* getSharedLibrariesJSON(const char* pathPrefix);
+
+#endif // LIBRARY_INDEX_H
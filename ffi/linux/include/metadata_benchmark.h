@@ -0,0 +1,19 @@
+#ifndef METADATA_BENCHMARK_H
+#define METADATA_BENCHMARK_H
+
+// Filesystem metadata benchmark (create, stat, readdir, rename, unlink) in
+// a scratch directory. Runs only when explicitly started, on a background
+// thread; results are kept per filesystem type and directory.
+
+// Starts a run in `directory` with `fileCount` files (default 20000) spread
+// over `threads` workers (default 4), each in its own subdirectory.
+// Returns false if a run is already active.
+bool startMetadataBenchmark(const char* directory, int fileCount, int threads);
+
+// Requests cancellation of the active run; the scratch files are removed.
+void cancelMetadataBenchmark();
+
+// Progress of the active run plus every kept result.
+char* getMetadataBenchmarkJSON();
+
+#endif // METADATA_BENCHMARK_H
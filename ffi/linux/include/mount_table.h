@@ -0,0 +1,34 @@
+#ifndef MOUNT_TABLE_H
+#define MOUNT_TABLE_H
+
+#include <string>
+#include <vector>
+
+// One line of /proc/self/mountinfo.
+struct MountEntry {
+    int mountId;
+    int parentId;
+    unsigned major;
+    unsigned minor;
+    std::string root;        // Path inside the filesystem (differs for bind mounts)
+    std::string mountPoint;
+    std::string fsType;
+    std::string source;
+    bool readOnly;
+    bool network;            // NFS, CIFS, FUSE, ... (statvfs may hang)
+};
+
+// Mounts of real filesystems. /proc/self/mountinfo is only re-parsed after
+// the kernel signals a change with POLLPRI.
+std::vector<MountEntry> currentMounts();
+
+// The mounts of a mountinfo text, without pseudo filesystems (proc, sysfs,
+// cgroup, ...). tmpfs, network and anonymous-device filesystems are kept.
+std::vector<MountEntry> parseMountInfo(const std::string& text);
+
+// Mount table with capacities. statvfs() runs on worker threads; a mount
+// that does not answer within `timeoutMs` is reported with its last known
+// values and "stale": true instead of blocking the call.
+char* getMountTableJSON(int timeoutMs);
+
+#endif // MOUNT_TABLE_H
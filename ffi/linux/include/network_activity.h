@@ -0,0 +1,42 @@
+#ifndef NETWORK_ACTIVITY_H
+#define NETWORK_ACTIVITY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Per-interface throughput from /proc/net/dev deltas on the shared sampling
+// cadence. Interface attributes come from /sys/class/net and are re-read
+// only when rtnetlink reports RTM_NEWLINK/RTM_DELLINK.
+struct NetworkActivity {
+    std::string interface;
+    int ifIndex;
+    std::string operState;   // "up", "down", "unknown", ...
+    std::string macAddress;
+    int mtu;
+    int64_t speedMbps;       // -1 when the driver does not report one
+    bool loopback;
+    bool wireless;
+    bool virtualDevice;      // No backing device (bridges, veth, tun, ...)
+    double rxBytesPerSec;
+    double txBytesPerSec;
+    double rxPacketsPerSec;
+    double txPacketsPerSec;
+    double rxErrorsPerSec;
+    double txErrorsPerSec;
+    double rxDropsPerSec;
+    double txDropsPerSec;
+    uint64_t rxBytes;        // Totals since the interface came up
+    uint64_t txBytes;
+    uint64_t rxErrors;
+    uint64_t txErrors;
+    uint64_t rxDrops;
+    uint64_t txDrops;
+};
+
+// Latest computed values; never blocks on a new sample.
+std::vector<NetworkActivity> latestNetworkActivity();
+
+char* getNetworkActivityJSON();
+
+#endif // NETWORK_ACTIVITY_H
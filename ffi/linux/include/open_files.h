@@ -0,0 +1,48 @@
+#ifndef OPEN_FILES_H
+#define OPEN_FILES_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Classification of a /proc/[pid]/fd link target.
+enum class FdKind { File, Socket, Pipe, AnonInode, EventFd, Other };
+
+struct OpenFdEntry {
+    int fd;
+    FdKind kind;
+    std::string target;    // readlink() result, e.g. "/var/log/syslog" or "socket:[1234]"
+    uint64_t inode;        // For socket:/pipe: targets, otherwise 0
+};
+
+// One row of /proc/net/{tcp,tcp6,udp,udp6,unix}.
+struct SocketEntry {
+    std::string protocol;  // "tcp", "tcp6", "udp", "udp6" or "unix"
+    std::string localAddress;
+    int localPort;
+    std::string remoteAddress;
+    int remotePort;
+    std::string state;     // "LISTEN", "ESTABLISHED", ... ("UNCONN" for idle udp/unix)
+    std::string path;      // unix sockets only
+};
+
+// Socket inode -> socket, parsed once per sweep and shared by all processes.
+typedef std::unordered_map<uint64_t, SocketEntry> SocketTable;
+
+// Parses /proc/net/{tcp,tcp6,udp,udp6,unix} (as seen from `procRoot`).
+SocketTable readSocketTable(const char* procRoot = "/proc");
+
+// Only /proc/net/tcp and tcp6.
+SocketTable readTcpSocketTable(const char* procRoot = "/proc");
+
+// Lists the open descriptors of the process whose /proc/[pid] dir is `pidFd`.
+// Returns false if the fd directory cannot be read (usually EACCES).
+bool listProcessFds(int pidFd, std::vector<OpenFdEntry>& out);
+
+const char* fdKindName(FdKind kind);
+
+// Open files and sockets of `pid`, or of every process when pid <= 0.
+char* getOpenFilesJSON(int pid);
+
+#endif // OPEN_FILES_H
@@ -0,0 +1,13 @@
+#ifndef OS_INFO_H
+#define OS_INFO_H
+
+#include <string>
+
+// Standard C++ function declarations
+char* getOsInfoJson();
+
+// The osInfo() JSON. With `cached` false the static fields are re-read into
+// a local copy and the shared cache is left alone.
+std::string buildOsInfoJson(bool cached);
+
+#endif // OS_INFO_H
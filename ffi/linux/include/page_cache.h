@@ -0,0 +1,20 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+// Page-cache residency of files under a path (a file or a directory tree),
+// measured with cachestat(2) when the kernel has it and mincore(2) on
+// windowed read-only mappings otherwise. Neither faults pages in. The walk
+// runs on a background thread and stays on the filesystem of the path.
+
+// Starts a walk of `path`, which is required. Returns false if it cannot be
+// stat'ed or a walk is already running.
+bool startPageCacheScan(const char* path);
+
+// Requests cancellation of the active walk; what it measured is kept.
+void cancelPageCacheScan();
+
+// Progress and the `topN` (<= 0: 50) most cached files next to meminfo's
+// Cached. "truncated" is set when the walk hit its file cap or was cancelled.
+char* getPageCacheJSON(int topN);
+
+#endif // PAGE_CACHE_H
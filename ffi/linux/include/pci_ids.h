@@ -0,0 +1,16 @@
+#ifndef PCI_IDS_H
+#define PCI_IDS_H
+
+#include <string>
+#include <cstdint>
+
+// Vendor/device names from the system pci.ids database. The file is
+// mmap'ed on first use and indexed lazily: a sorted vendor offset table on
+// the first lookup, and a device table per vendor on the first lookup of
+// that vendor. Both are binary searched; nothing is parsed up front.
+
+// Returns false if the id is unknown or no pci.ids file is installed.
+bool pciVendorName(uint16_t vendor, std::string& name);
+bool pciDeviceName(uint16_t vendor, uint16_t device, std::string& name);
+
+#endif // PCI_IDS_H
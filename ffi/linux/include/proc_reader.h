@@ -0,0 +1,56 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <string>
+#include <cstdint>
+#include <sys/types.h>
+
+// Small helpers shared by the procfs/sysfs collectors. Everything here avoids
+// iostreams and popen so a full /proc sweep stays cheap.
+
+// Reads a whole file into `out`. Returns false if it could not be opened.
+bool readFile(const char* path, std::string& out);
+
+// Same as readFile() but relative to an already opened directory fd.
+bool readFileAt(int dirfd, const char* name, std::string& out);
+
+// Returns the number of a "Key:   1234 kB" style line (the unit is not
+// interpreted, so it also works for "read_bytes: 4096"), or 0 when missing.
+uint64_t findKbField(const std::string& text, const char* key);
+
+// Escapes quotes, backslashes and control characters for JSON output.
+std::string jsonEscape(const std::string& str);
+
+// Fields of /proc/[pid]/stat (or task/[tid]/stat) that the collectors use.
+struct ProcStat {
+    std::string comm;
+    char state;
+    int ppid;
+    uint64_t minorFaults;
+    uint64_t majorFaults;
+    uint64_t utimeTicks;
+    uint64_t stimeTicks;
+    int numThreads;
+    uint64_t startTicks;   // Clock ticks after boot
+    uint64_t rssPages;
+};
+
+// Parses the contents of a stat file. Returns false on malformed input.
+bool parseProcStat(const std::string& text, ProcStat& stat);
+
+// read_bytes/write_bytes from /proc/[pid]/io. Returns false if denied.
+bool readProcIo(int pidFd, uint64_t& readBytes, uint64_t& writeBytes);
+
+// Cached sysconf(_SC_CLK_TCK) and page size in kilobytes.
+long clockTicksPerSecond();
+long pageSizeKB();
+
+// Boot time (seconds since epoch) from the "btime" line of /proc/stat.
+uint64_t bootTimeSeconds();
+
+// Kernel name of the block device behind `dev` (e.g. "nvme0n1p2"), or of the
+// whole disk when `wholeDisk` is set ("nvme0n1"). Empty for non-block
+// filesystems such as tmpfs or NFS.
+std::string blockDeviceName(dev_t dev, bool wholeDisk);
+
+#endif // PROC_READER_H
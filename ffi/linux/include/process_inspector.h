@@ -0,0 +1,17 @@
+#ifndef PROCESS_INSPECTOR_H
+#define PROCESS_INSPECTOR_H
+
+// Focused-process inspector: samples one pid (and its threads) on a timerfd
+// driven background thread into a preallocated ring buffer.
+
+// Starts a session. `hz` is clamped to 1..100, `capacity` to 16..65536 samples.
+// Returns an opaque handle, or nullptr if the pid cannot be opened.
+void* startProcessInspector(int pid, int hz, int capacity);
+
+// Returns all samples recorded since the previous call as a JSON string.
+char* getProcessInspectorSamplesJSON(void* session);
+
+// Stops sampling and frees the session. Safe to use as a native finalizer.
+void releaseProcessInspector(void* session);
+
+#endif // PROCESS_INSPECTOR_H
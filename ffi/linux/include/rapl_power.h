@@ -0,0 +1,37 @@
+#ifndef RAPL_POWER_H
+#define RAPL_POWER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// RAPL energy counters from /sys/class/powercap/intel-rapl* (the same
+// powercap driver exposes AMD Zen package/core domains). Sampled on the
+// shared sampler; counters wrap at max_energy_range_uj.
+
+struct RaplDomain {
+    std::string zone;        // "intel-rapl:0:1"
+    std::string name;        // "package-0", "core", "uncore", "dram", "psys"
+    bool package;            // Top-level zone (package-N or psys)
+    bool readable;           // energy_uj is root-only since Linux 5.10
+    double watts;            // Average over the last interval
+    double joules;           // Accumulated since the collector started
+};
+
+std::vector<RaplDomain> raplDomains();
+
+// Sum of the package-N domains over the last interval. Returns false when
+// RAPL is missing or unreadable.
+bool raplPackageWatts(double& watts);
+
+// Joules of the same domains accumulated since the collector started. The
+// counters are read at call time, so callers can average over their own
+// interval.
+bool raplPackageJoules(double& joules);
+
+// For testing against a fake tree; defaults to "/sys".
+void setPowercapRoot(const char* root);
+
+char* getRaplPowerJSON();
+
+#endif // RAPL_POWER_H
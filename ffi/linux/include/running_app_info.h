@@ -0,0 +1,56 @@
+#ifndef RUNNING_APP_INFO_H
+#define RUNNING_APP_INFO_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Proportional/unique memory from /proc/[pid]/smaps_rollup (all in kilobytes).
+struct DeepMemoryInfo {
+    uint64_t pss;
+    uint64_t uss;          // Private_Clean + Private_Dirty
+    uint64_t swap;
+    uint64_t swapPss;
+    int64_t ageMs;         // Age of the cached sample, -1 if never sampled
+};
+
+// Structure to hold detailed process information.
+struct ProgramInfo {
+    int pid;
+    int parentPid;
+    std::string name;
+    double cpuUsage;       // CPU usage since the previous sweep (percentage)
+    int memoryUsage;       // Resident memory (in kilobytes)
+    std::string executablePath;
+    std::string startTime; // ISO8601 formatted string, e.g. "2022-03-15T14:30:00"
+    int threadCount;
+    std::string user;
+    std::string state;     // Process state as a single character (e.g. "R", "S", "T", "Z")
+    std::string windowTitle; // Window title (not available on Linux, always "0")
+    uint64_t startTicks;   // Start time in clock ticks after boot, used to detect pid reuse
+    uint64_t cpuTicks;     // Accumulated utime + stime
+    uint64_t readBytes;    // Storage I/O from /proc/[pid]/io (0 if denied)
+    uint64_t writeBytes;
+    double readBytesPerSec;  // Since the previous sweep
+    double writeBytesPerSec;
+    DeepMemoryInfo deepMemory;
+    double gpuUsage;       // Busiest GPU engine since the previous sweep (DRM fdinfo)
+    uint64_t gpuMemory;    // GPU memory of the process's DRM clients (in kilobytes)
+    uint64_t contextSwitches;  // Voluntary + involuntary, from /proc/[pid]/status
+    double wakeupsPerSec;  // Context switches per second since the previous sweep
+    double energyImpact;   // Weighted CPU, wakeups, disk I/O and GPU score
+    double energyWatts;    // Share of measured RAPL package power, -1 without RAPL
+};
+
+// Sweeps /proc and returns one entry per process. A call within 500 ms of
+// the previous sweep returns that sweep's results.
+std::vector<ProgramInfo> collectRunningPrograms();
+
+// Enables the smaps_rollup based deep memory mode. Values <= 0 keep the
+// current refresh interval / per-sweep time budget.
+void setDeepMemoryMode(int enabled, int refreshIntervalMs, int sweepBudgetMs);
+
+// Standard C++ function declarations
+char* getRunningProcessesJSON();
+
+#endif // RUNNING_APP_INFO_H
@@ -0,0 +1,22 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <functional>
+
+// Shared background sampling cadence. Delta-based collectors (disk, network,
+// GPU, power, ...) register a callback once and read their latest computed
+// values from memory, so FFI calls never sleep waiting for a second sample.
+
+// Registers `tick` under `name` (no-op if already registered), takes a first
+// sample immediately on the caller's thread, and starts the sampler thread.
+// `tick` receives CLOCK_MONOTONIC nanoseconds.
+void registerSampler(const char* name, std::function<void(uint64_t)> tick);
+
+// Changes the cadence (clamped to 50..60000 ms, default 1000 ms).
+void setSamplingInterval(int intervalMs);
+int samplingIntervalMs();
+
+uint64_t monotonicNanos();
+
+#endif // SAMPLER_H
@@ -0,0 +1,16 @@
+#ifndef UEVENT_MONITOR_H
+#define UEVENT_MONITOR_H
+
+// Kernel uevents (the netlink feed udev listens to), used to invalidate
+// sysfs-derived caches only when hardware actually changes.
+
+// Opens a non-blocking NETLINK_KOBJECT_UEVENT socket subscribed to kernel
+// events. Returns -1 if netlink is unavailable (e.g. in some containers).
+int openUeventSocket();
+
+// Reads every pending event without blocking. Returns true if at least one
+// had SUBSYSTEM=`subsystem`, or if the socket overflowed (ENOBUFS) and
+// events may have been lost.
+bool drainUevents(int fd, const char* subsystem);
+
+#endif // UEVENT_MONITOR_H
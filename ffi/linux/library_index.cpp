@@ -0,0 +1,208 @@
+#include "include/library_index.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Processes that were already indexed get their maps re-read a few at a
+// time, so libraries loaded later with dlopen() show up without a full rescan.
+static const size_t kRescanPerUpdate = 32;
+
+struct MappingKey {
+    uint64_t dev;
+    uint64_t inode;
+    string path;    // Same inode may appear as "foo.so" and "foo.so (deleted)"
+    bool operator<(const MappingKey& o) const {
+        if (path != o.path) return path < o.path;
+        if (dev != o.dev) return dev < o.dev;
+        return inode < o.inode;
+    }
+};
+
+struct MappingUsers {
+    map<int, uint64_t> pids;   // pid -> mapped size in KB
+    uint64_t totalKB = 0;
+};
+
+struct IndexedProcess {
+    uint64_t startTicks;
+    bool mapsReadable;     // False for kernel threads and EACCES; not retried
+    vector<pair<MappingKey, uint64_t>> mappings;  // Contributions to undo on exit
+};
+
+static mutex indexMutex;
+// Ordered by path so prefix queries are a lower_bound() plus a short walk.
+static map<MappingKey, MappingUsers> mappingIndex;
+static unordered_map<int, IndexedProcess> indexedProcesses;
+static size_t rescanCursor = 0;
+
+// Collects per-file mapped sizes from /proc/[pid]/maps.
+static bool readFileMappings(int pidFd, vector<pair<MappingKey, uint64_t>>& out) {
+    out.clear();
+    string text;
+    if (!readFileAt(pidFd, "maps", text) || text.empty()) return false;
+    map<MappingKey, uint64_t> sizes;
+    istringstream iss(text);
+    string line;
+    while (getline(iss, line)) {
+        // start-end perms offset major:minor inode path
+        unsigned long long start, end, inode;
+        unsigned major, minor;
+        int consumed = 0;
+        if (sscanf(line.c_str(), "%llx-%llx %*s %*s %x:%x %llu%n",
+                   &start, &end, &major, &minor, &inode, &consumed) != 5 || inode == 0) {
+            continue;
+        }
+        size_t pathStart = line.find_first_not_of(' ', (size_t)consumed);
+        if (pathStart == string::npos) continue;
+        MappingKey key{((uint64_t)major << 32) | minor, inode, line.substr(pathStart)};
+        sizes[key] += (end - start) / 1024;
+    }
+    out.assign(sizes.begin(), sizes.end());
+    return true;
+}
+
+static void removeProcess(int pid, const IndexedProcess& proc) {
+    for (const auto& m : proc.mappings) {
+        auto it = mappingIndex.find(m.first);
+        if (it == mappingIndex.end()) continue;
+        it->second.pids.erase(pid);
+        it->second.totalKB -= m.second;
+        if (it->second.pids.empty()) mappingIndex.erase(it);
+    }
+}
+
+static void addProcess(int pid, IndexedProcess& proc) {
+    for (const auto& m : proc.mappings) {
+        MappingUsers& users = mappingIndex[m.first];
+        users.pids[pid] = m.second;
+        users.totalKB += m.second;
+    }
+}
+
+static void indexProcess(int pid, int pidFd, uint64_t startTicks) {
+    IndexedProcess proc;
+    proc.startTicks = startTicks;
+    // Unreadable maps (kernel thread or no permission) are recorded too, so
+    // the pid is not opened again until it exits or is reused.
+    proc.mapsReadable = readFileMappings(pidFd, proc.mappings);
+    if (proc.mapsReadable) addProcess(pid, proc);
+    indexedProcesses[pid] = std::move(proc);
+}
+
+//
+// Incremental update: only processes that started or exited since the last
+// call touch the index, plus a small round-robin rescan of existing ones.
+//
+static void updateLibraryIndex() {
+    int procFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) return;
+    DIR* dir = fdopendir(procFd);
+    if (!dir) {
+        close(procFd);
+        return;
+    }
+
+    unordered_map<int, uint64_t> live;
+    vector<int> existing;
+    string text;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        int pidFd = openat(procFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidFd < 0) continue;
+        ProcStat stat;
+        if (readFileAt(pidFd, "stat", text) && parseProcStat(text, stat)) {
+            int pid = atoi(entry->d_name);
+            live[pid] = stat.startTicks;
+            auto it = indexedProcesses.find(pid);
+            if (it == indexedProcesses.end()) {
+                indexProcess(pid, pidFd, stat.startTicks);
+            } else if (it->second.startTicks != stat.startTicks) {
+                // pid was reused by a new process
+                removeProcess(pid, it->second);
+                indexedProcesses.erase(it);
+                indexProcess(pid, pidFd, stat.startTicks);
+            } else if (it->second.mapsReadable) {
+                existing.push_back(pid);
+            }
+        }
+        close(pidFd);
+    }
+    closedir(dir);
+
+    for (auto it = indexedProcesses.begin(); it != indexedProcesses.end();) {
+        if (live.find(it->first) == live.end()) {
+            removeProcess(it->first, it->second);
+            it = indexedProcesses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (size_t i = 0; i < kRescanPerUpdate && i < existing.size(); i++) {
+        int pid = existing[(rescanCursor + i) % existing.size()];
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/%d", pid);
+        int pidFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidFd < 0) continue;
+        auto it = indexedProcesses.find(pid);
+        removeProcess(pid, it->second);
+        uint64_t startTicks = it->second.startTicks;
+        indexedProcesses.erase(it);
+        indexProcess(pid, pidFd, startTicks);
+        close(pidFd);
+    }
+    rescanCursor = existing.empty() ? 0 : (rescanCursor + kRescanPerUpdate) % existing.size();
+}
+
+static string getSharedLibrariesJSON_Internal(const string& prefix) {
+    lock_guard<mutex> lock(indexMutex);
+    updateLibraryIndex();
+
+    ostringstream json;
+    json << "{ \"shared_libraries\": [";
+    bool first = true;
+    for (auto it = mappingIndex.lower_bound(MappingKey{0, 0, prefix});
+         it != mappingIndex.end() && it->first.path.compare(0, prefix.size(), prefix) == 0; ++it) {
+        const MappingKey& key = it->first;
+        const MappingUsers& users = it->second;
+        if (!first) json << ", ";
+        first = false;
+        const string deletedSuffix = " (deleted)";
+        bool deleted = key.path.size() > deletedSuffix.size() &&
+            key.path.compare(key.path.size() - deletedSuffix.size(), deletedSuffix.size(), deletedSuffix) == 0;
+        json << "{";
+        json << "\"path\": \"" << jsonEscape(key.path) << "\", ";
+        json << "\"device\": \"" << (key.dev >> 32) << ":" << (key.dev & 0xffffffffULL) << "\", ";
+        json << "\"inode\": " << key.inode << ", ";
+        json << "\"deleted\": " << (deleted ? "true" : "false") << ", ";
+        json << "\"mappedSize\": " << users.totalKB << ", ";
+        json << "\"processCount\": " << users.pids.size() << ", ";
+        json << "\"pids\": [";
+        for (auto p = users.pids.begin(); p != users.pids.end(); ++p) {
+            if (p != users.pids.begin()) json << ", ";
+            json << p->first;
+        }
+        json << "]}";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getSharedLibrariesJSON(const char* pathPrefix) {
+    return strdup_cstr(getSharedLibrariesJSON_Internal(pathPrefix ? pathPrefix : ""));
+}
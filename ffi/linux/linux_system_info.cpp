@@ -0,0 +1,256 @@
+#include "include/running_app_info.h"
+#include "include/process_inspector.h"
+#include "include/open_files.h"
+#include "include/library_index.h"
+#include "include/app_groups.h"
+#include "include/disk_info.h"
+#include "include/disk_benchmark.h"
+#include "include/metadata_benchmark.h"
+#include "include/disk_activity.h"
+#include "include/sampler.h"
+#include "include/mount_table.h"
+#include "include/directory_scan.h"
+#include "include/duplicate_finder.h"
+#include "include/block_devices.h"
+#include "include/page_cache.h"
+#include "include/gpu_sampler.h"
+#include "include/gpu_info.h"
+#include "include/battery_info.h"
+#include "include/battery_model.h"
+#include "include/rapl_power.h"
+#include "include/os_info.h"
+#include "include/network_activity.h"
+#include "include/connection_table.h"
+#include "include/free_cstr.h"
+
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include "include/strdup_cstr.h"
+
+extern "C" {
+
+// Get Running Processes
+__attribute__((visibility("default"))) char* runningProcesses() {
+    return getRunningProcessesJSON(); // Calls implementation from running_app_info.cpp
+}
+
+// Enable/disable PSS/USS/swap figures in runningProcesses() (<= 0 keeps defaults)
+__attribute__((visibility("default"))) void deepMemoryMode(int enabled, int refreshIntervalMs, int sweepBudgetMs) {
+    setDeepMemoryMode(enabled, refreshIntervalMs, sweepBudgetMs);
+}
+
+// Start sampling one pid at up to 100 Hz; returns an opaque session handle
+__attribute__((visibility("default"))) void* inspectProcess(int pid, int hz, int capacity) {
+    return startProcessInspector(pid, hz, capacity);
+}
+
+// Drain the samples recorded since the previous call
+__attribute__((visibility("default"))) char* inspectorSamples(void* session) {
+    return getProcessInspectorSamplesJSON(session);
+}
+
+// Stop sampling and free the session (usable as a NativeFinalizer callback)
+__attribute__((visibility("default"))) void releaseInspector(void* session) {
+    releaseProcessInspector(session);
+}
+
+// Get open files and sockets of one process (pid <= 0 for every process)
+__attribute__((visibility("default"))) char* openFiles(int pid) {
+    return getOpenFilesJSON(pid);
+}
+
+// Get file-backed mappings (shared libraries) under a path prefix and the pids using them
+__attribute__((visibility("default"))) char* sharedLibraries(const char* pathPrefix) {
+    return getSharedLibrariesJSON(pathPrefix);
+}
+
+// Get running processes folded into applications with per-app aggregates
+__attribute__((visibility("default"))) char* applications() {
+    return getApplicationGroupsJSON();
+}
+
+// Get Disk Details
+__attribute__((visibility("default"))) char* diskDetails() {
+    return getDiskInfo(); // Calls implementation from disk_info.cpp
+}
+
+// Start a storage benchmark in `directory` (values <= 0 select defaults)
+__attribute__((visibility("default"))) int diskBenchmarkStart(const char* directory, int seqBlockKB, int randBlockKB,
+                                                              int queueDepth, int fileSizeMB, int durationMs) {
+    return startDiskBenchmark(directory, seqBlockKB, randBlockKB, queueDepth, fileSizeMB, durationMs) ? 1 : 0;
+}
+
+// Cancel the running storage benchmark
+__attribute__((visibility("default"))) void diskBenchmarkCancel() {
+    cancelDiskBenchmark();
+}
+
+// Get storage benchmark progress and cached per-device results
+__attribute__((visibility("default"))) char* diskBenchmarkResults() {
+    return getDiskBenchmarkJSON();
+}
+
+// Start a filesystem metadata benchmark in `directory` (values <= 0 select defaults)
+__attribute__((visibility("default"))) int metadataBenchmarkStart(const char* directory, int fileCount, int threads) {
+    return startMetadataBenchmark(directory, fileCount, threads) ? 1 : 0;
+}
+
+// Cancel the running metadata benchmark
+__attribute__((visibility("default"))) void metadataBenchmarkCancel() {
+    cancelMetadataBenchmark();
+}
+
+// Get metadata benchmark progress and results per filesystem
+__attribute__((visibility("default"))) char* metadataBenchmarkResults() {
+    return getMetadataBenchmarkJSON();
+}
+
+// Get live per-device throughput, IOPS, latency and utilization
+__attribute__((visibility("default"))) char* diskActivity() {
+    return getDiskActivityJSON();
+}
+
+// Set the shared background sampling cadence in milliseconds
+__attribute__((visibility("default"))) void samplingInterval(int intervalMs) {
+    setSamplingInterval(intervalMs);
+}
+
+// Get mounted filesystems with capacities; hung mounts are reported stale
+__attribute__((visibility("default"))) char* mountTable(int timeoutMs) {
+    return getMountTableJSON(timeoutMs);
+}
+
+// Start a disk usage crawl of `path` (values <= 0 select defaults)
+__attribute__((visibility("default"))) int directoryScanStart(const char* path, int threads, int topFiles, int staleDays) {
+    return startDirectoryScan(path, threads, topFiles, staleDays) ? 1 : 0;
+}
+
+// Cancel the running disk usage crawl
+__attribute__((visibility("default"))) void directoryScanCancel() {
+    cancelDirectoryScan();
+}
+
+// Get crawl progress and the size tree below `nodeId`, `depth` levels deep
+__attribute__((visibility("default"))) char* directoryScanResults(int nodeId, int depth) {
+    return getDirectoryScanJSON(nodeId, depth);
+}
+
+// Get the largest files, stale files and per-extension sizes of the crawl
+__attribute__((visibility("default"))) char* directoryScanFindings() {
+    return getDirectoryScanFindingsJSON();
+}
+
+// Start a duplicate file search below `path` (values <= 0 select defaults)
+__attribute__((visibility("default"))) int duplicateScanStart(const char* path, int minSizeKB, int threads) {
+    return startDuplicateScan(path, minSizeKB, threads) ? 1 : 0;
+}
+
+// Cancel the running duplicate file search
+__attribute__((visibility("default"))) void duplicateScanCancel() {
+    cancelDuplicateScan();
+}
+
+// Get duplicate search progress and the groups with the most reclaimable bytes
+__attribute__((visibility("default"))) char* duplicateScanResults(int maxGroups) {
+    return getDuplicateScanJSON(maxGroups);
+}
+
+// Get block device descriptors (model, scheduler, partitions, stacking, mounts)
+__attribute__((visibility("default"))) char* blockDeviceDetails() {
+    return getBlockDevicesJSON();
+}
+
+// Start measuring page-cache residency of files under `path` (a file or directory tree)
+__attribute__((visibility("default"))) int pageCacheStart(const char* path) {
+    return startPageCacheScan(path) ? 1 : 0;
+}
+
+// Cancel the running page-cache walk
+__attribute__((visibility("default"))) void pageCacheCancel() {
+    cancelPageCacheScan();
+}
+
+// Get page-cache walk progress and the most cached files
+__attribute__((visibility("default"))) char* pageCacheResults(int topN) {
+    return getPageCacheJSON(topN);
+}
+
+// Get GPU Info
+__attribute__((visibility("default"))) char* gpuInfo() {
+    return getGPUInfo(); // Calls implementation from gpu_info.cpp
+}
+
+// Get every display controller with PCIe link and driver details
+__attribute__((visibility("default"))) char* gpuDevices() {
+    return getGpuDevicesJSON();
+}
+
+// Get GPU Usage (busiest card at the last background sample)
+__attribute__((visibility("default"))) double gpuUsages() {
+    return getGPUUsage();
+}
+
+// Get recent per-card GPU samples (busy %, VRAM, clock, temperature)
+__attribute__((visibility("default"))) char* gpuSamples(int maxSamples) {
+    return getGpuSamplesJSON(maxSamples);
+}
+
+// Point the GPU sampler at another sysfs root (for testing against a fake tree)
+__attribute__((visibility("default"))) void gpuSysfsRoot(const char* root) {
+    setGpuSysfsRoot(root);
+}
+
+// Get Battery Info (all system batteries plus AC state)
+__attribute__((visibility("default"))) char* batteryInfo() {
+    return getBatteryInfo(); // Calls implementation from battery_info.cpp
+}
+
+// Get the smoothed power model: time to empty/full with bands, charge sessions
+__attribute__((visibility("default"))) char* batteryModel() {
+    return getBatteryModelJSON();
+}
+
+// Set the discharge-rate smoothing time constant in seconds
+__attribute__((visibility("default"))) void batteryModelTimeConstant(int seconds) {
+    setBatteryModelTimeConstant(seconds);
+}
+
+// Point the battery collector at another sysfs root (for testing against a fake tree)
+__attribute__((visibility("default"))) void powerSupplyRoot(const char* root) {
+    setPowerSupplyRoot(root);
+}
+
+// Get RAPL package/core/DRAM power per domain over the last sample interval
+__attribute__((visibility("default"))) char* raplPower() {
+    return getRaplPowerJSON();
+}
+
+// Point the RAPL collector at another sysfs root (for testing against a fake tree)
+__attribute__((visibility("default"))) void powercapRoot(const char* root) {
+    setPowercapRoot(root);
+}
+
+// Get OS Info
+__attribute__((visibility("default"))) char* osInfo() {
+    return getOsInfoJson(); // Calls implementation from os_info.cpp
+}
+
+// Get per-interface network throughput, errors and drops since the previous sample
+__attribute__((visibility("default"))) char* networkActivity() {
+    return getNetworkActivityJSON();
+}
+
+// Get TCP connections (sock_diag) filtered by a (1 << state) mask, 0 for all
+__attribute__((visibility("default"))) char* connectionTable(int stateMask, int maxConnections) {
+    return getConnectionTableJSON(stateMask, maxConnections);
+}
+
+// Free allocated memory for FFI
+__attribute__((visibility("default"))) void free_cstr(char* ptr) {
+    if (ptr) {
+        free(ptr);
+    }
+}
+
+}
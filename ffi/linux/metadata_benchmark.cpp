@@ -0,0 +1,338 @@
+#include "include/metadata_benchmark.h"
+#include "include/latency_histogram.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+
+using namespace std;
+
+// Each worker lists its directory this many times in the readdir phase.
+static const int kReaddirPasses = 5;
+
+enum class MetaPhase { Idle, Create, Stat, Readdir, Rename, Unlink, Cleanup };
+static const int kMetaTests = 5;
+
+struct MetaConfig {
+    string directory;
+    int fileCount;
+    int threads;
+};
+
+struct MetaTestResult {
+    bool ran = false;
+    uint64_t operations = 0;
+    double opsPerSec = 0.0;
+    // Latency percentiles in microseconds.
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;
+};
+
+struct MetaBenchmarkResult {
+    string fileSystem;
+    MetaConfig config;
+    bool cancelled = false;
+    string error;
+    time_t finishedAt = 0;
+    MetaTestResult tests[kMetaTests];   // Indexed by phase - Create
+};
+
+static mutex metaMutex;
+static map<string, MetaBenchmarkResult> metaResults;   // "fs:directory"
+static atomic<bool> metaRunning(false);
+static atomic<bool> metaCancel(false);
+static atomic<int> metaPhase((int)MetaPhase::Idle);
+static atomic<uint64_t> phaseOpsDone(0);
+static atomic<uint64_t> phaseOpsTotal(0);
+
+static const char* metaPhaseName(MetaPhase phase) {
+    switch (phase) {
+        case MetaPhase::Create: return "create";
+        case MetaPhase::Stat: return "stat";
+        case MetaPhase::Readdir: return "readdir";
+        case MetaPhase::Rename: return "rename";
+        case MetaPhase::Unlink: return "unlink";
+        case MetaPhase::Cleanup: return "cleanup";
+        default: return "idle";
+    }
+}
+
+// Filesystem name from the statfs() magic, so overlayfs is not reported as
+// the filesystem underneath it.
+static string fileSystemName(const char* directory) {
+    struct statfs st;
+    if (statfs(directory, &st) != 0) return "unknown";
+    switch ((unsigned long)st.f_type) {
+        case 0xEF53: return "ext4";
+        case 0x58465342: return "xfs";
+        case 0x9123683E: return "btrfs";
+        case 0x794C7630: return "overlay";
+        case 0x01021994: return "tmpfs";
+        case 0xF2F52010: return "f2fs";
+        case 0x2FC12FC1: return "zfs";
+        case 0x6969: return "nfs";
+        case 0xFF534D42: return "cifs";
+        case 0x65735546: return "fuse";
+        case 0x4D44: return "vfat";
+        case 0x5346544E: return "ntfs";
+        default: {
+            char hex[32];
+            snprintf(hex, sizeof(hex), "0x%lx", (unsigned long)st.f_type);
+            return hex;
+        }
+    }
+}
+
+static void fileName(char* out, size_t size, const char* prefix, int index) {
+    snprintf(out, size, "%s%07d", prefix, index);
+}
+
+//
+// Runs one operation type on every worker. Worker w owns subdirectory
+// "w<w>" and files [0, perThread), so workers never share a directory.
+//
+static MetaTestResult runMetaTest(MetaPhase phase, const vector<int>& dirFds, int perThread) {
+    const size_t threads = dirFds.size();
+    vector<LatencyHistogram> histograms(threads);
+    vector<uint64_t> ops(threads, 0);
+    atomic<bool> failed(false);
+    phaseOpsDone = 0;
+    phaseOpsTotal = phase == MetaPhase::Readdir ? (uint64_t)threads * kReaddirPasses
+                                                : (uint64_t)threads * (uint64_t)perThread;
+    metaPhase = (int)phase;
+
+    const auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (size_t w = 0; w < threads; w++) {
+        workers.emplace_back([&, w]() {
+            int dirFd = dirFds[w];
+            LatencyHistogram& hist = histograms[w];
+            char name[32], newName[32];
+            struct stat st;
+            if (phase == MetaPhase::Readdir) {
+                // One operation per entry; latency is per full listing.
+                for (int pass = 0; pass < kReaddirPasses && !metaCancel; pass++) {
+                    auto t0 = chrono::steady_clock::now();
+                    int fd = openat(dirFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                    DIR* dir = fd >= 0 ? fdopendir(fd) : nullptr;
+                    if (!dir) {
+                        if (fd >= 0) close(fd);
+                        failed = true;
+                        return;
+                    }
+                    struct dirent* entry;
+                    while ((entry = readdir(dir)) != nullptr) {
+                        if (entry->d_name[0] != '.') ops[w]++;
+                    }
+                    closedir(dir);
+                    hist.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+                    phaseOpsDone++;
+                }
+                return;
+            }
+            for (int i = 0; i < perThread && !metaCancel; i++) {
+                fileName(name, sizeof(name), "f", i);
+                fileName(newName, sizeof(newName), "r", i);
+                auto t0 = chrono::steady_clock::now();
+                bool ok;
+                switch (phase) {
+                    case MetaPhase::Create: {
+                        int fd = openat(dirFd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+                        ok = fd >= 0;
+                        if (ok) close(fd);
+                        break;
+                    }
+                    case MetaPhase::Stat:
+                        ok = fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) == 0;
+                        break;
+                    case MetaPhase::Rename:
+                        ok = renameat(dirFd, name, dirFd, newName) == 0;
+                        break;
+                    default:
+                        ok = unlinkat(dirFd, newName, 0) == 0;
+                        break;
+                }
+                auto t1 = chrono::steady_clock::now();
+                if (!ok) {
+                    failed = true;
+                    return;
+                }
+                hist.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+                ops[w]++;
+                phaseOpsDone++;
+            }
+        });
+    }
+    for (thread& t : workers) t.join();
+    const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    MetaTestResult result;
+    if (failed || metaCancel) return result;
+    LatencyHistogram merged;
+    for (const LatencyHistogram& h : histograms) merged.merge(h);
+    for (uint64_t n : ops) result.operations += n;
+    result.ran = true;
+    result.opsPerSec = elapsed > 0 ? (double)result.operations / elapsed : 0.0;
+    result.p50 = (double)merged.percentile(0.50) / 1000.0;
+    result.p90 = (double)merged.percentile(0.90) / 1000.0;
+    result.p99 = (double)merged.percentile(0.99) / 1000.0;
+    result.p999 = (double)merged.percentile(0.999) / 1000.0;
+    result.max = (double)merged.max() / 1000.0;
+    return result;
+}
+
+// Removes whatever a (possibly cancelled or failed) run left behind.
+static void removeScratch(const string& scratch, int threads) {
+    for (int w = 0; w < threads; w++) {
+        string sub = scratch + "/w" + to_string(w);
+        DIR* dir = opendir(sub.c_str());
+        if (dir) {
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                if (entry->d_name[0] != '.') unlinkat(dirfd(dir), entry->d_name, 0);
+            }
+            closedir(dir);
+        }
+        rmdir(sub.c_str());
+    }
+    rmdir(scratch.c_str());
+}
+
+static void metadataThread(MetaConfig cfg, string fileSystem) {
+    MetaBenchmarkResult result;
+    result.fileSystem = fileSystem;
+    result.config = cfg;
+
+    string scratch = cfg.directory + "/.system_info_mdbench." + to_string(getpid());
+    vector<int> dirFds;
+    if (mkdir(scratch.c_str(), 0700) != 0) {
+        result.error = strerror(errno);
+    } else {
+        for (int w = 0; w < cfg.threads; w++) {
+            string sub = scratch + "/w" + to_string(w);
+            int fd = mkdir(sub.c_str(), 0700) == 0 ? open(sub.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) : -1;
+            if (fd < 0) {
+                result.error = strerror(errno);
+                break;
+            }
+            dirFds.push_back(fd);
+        }
+        if (result.error.empty()) {
+            int perThread = max(1, cfg.fileCount / cfg.threads);
+            // Order matters: each phase works on what the previous one left.
+            const MetaPhase order[] = {MetaPhase::Create, MetaPhase::Stat, MetaPhase::Readdir,
+                                       MetaPhase::Rename, MetaPhase::Unlink};
+            for (MetaPhase phase : order) {
+                if (metaCancel) break;
+                MetaTestResult& out = result.tests[(int)phase - (int)MetaPhase::Create];
+                out = runMetaTest(phase, dirFds, perThread);
+                if (!out.ran && !metaCancel) {
+                    result.error = string(metaPhaseName(phase)) + " failed";
+                    break;
+                }
+            }
+        }
+        for (int fd : dirFds) close(fd);
+        metaPhase = (int)MetaPhase::Cleanup;
+        removeScratch(scratch, cfg.threads);
+    }
+    result.cancelled = metaCancel;
+    result.finishedAt = time(nullptr);
+
+    {
+        lock_guard<mutex> lock(metaMutex);
+        // A cancelled run does not replace an earlier complete result.
+        string key = fileSystem + ":" + cfg.directory;
+        if (!result.cancelled || metaResults.find(key) == metaResults.end()) {
+            metaResults[key] = result;
+        }
+    }
+    metaPhase = (int)MetaPhase::Idle;
+    metaRunning = false;
+}
+
+bool startMetadataBenchmark(const char* directory, int fileCount, int threads) {
+    if (!directory || !*directory) return false;
+    struct stat st;
+    if (stat(directory, &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+
+    bool expected = false;
+    if (!metaRunning.compare_exchange_strong(expected, true)) return false;
+
+    MetaConfig cfg;
+    cfg.directory = directory;
+    cfg.threads = threads > 0 ? min(threads, 64) : 4;
+    cfg.fileCount = fileCount > 0 ? min(fileCount, 10000000) : 20000;
+
+    metaCancel = false;
+    thread(metadataThread, cfg, fileSystemName(directory)).detach();
+    return true;
+}
+
+void cancelMetadataBenchmark() {
+    metaCancel = true;
+}
+
+static void appendMetaTestJSON(ostringstream& json, const char* name, const MetaTestResult& t) {
+    json << "\"" << name << "\": {";
+    json << "\"ran\": " << (t.ran ? "true" : "false") << ", ";
+    json << "\"operations\": " << t.operations << ", ";
+    json << "\"opsPerSec\": " << t.opsPerSec << ", ";
+    json << "\"latencyUs\": {\"p50\": " << t.p50 << ", \"p90\": " << t.p90
+         << ", \"p99\": " << t.p99 << ", \"p999\": " << t.p999 << ", \"max\": " << t.max << "}}";
+}
+
+static string getMetadataBenchmarkJSON_Internal() {
+    ostringstream json;
+    MetaPhase phase = (MetaPhase)metaPhase.load();
+    uint64_t total = phaseOpsTotal;
+    json << "{ \"running\": " << (metaRunning ? "true" : "false") << ", ";
+    json << "\"phase\": \"" << metaPhaseName(phase) << "\", ";
+    json << "\"phaseProgress\": " << (total ? (double)phaseOpsDone / (double)total : 0.0) << ", ";
+    json << "\"results\": [";
+    lock_guard<mutex> lock(metaMutex);
+    bool first = true;
+    for (const auto& entry : metaResults) {
+        const MetaBenchmarkResult& r = entry.second;
+        if (!first) json << ", ";
+        first = false;
+        char stamp[64];
+        struct tm tm;
+        localtime_r(&r.finishedAt, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+        json << "{";
+        json << "\"fileSystem\": \"" << jsonEscape(r.fileSystem) << "\", ";
+        json << "\"directory\": \"" << jsonEscape(r.config.directory) << "\", ";
+        json << "\"fileCount\": " << r.config.fileCount << ", ";
+        json << "\"threads\": " << r.config.threads << ", ";
+        json << "\"finishedAt\": \"" << stamp << "\", ";
+        json << "\"cancelled\": " << (r.cancelled ? "true" : "false") << ", ";
+        json << "\"error\": \"" << jsonEscape(r.error) << "\", ";
+        for (int t = 0; t < kMetaTests; t++) {
+            appendMetaTestJSON(json, metaPhaseName((MetaPhase)(t + (int)MetaPhase::Create)), r.tests[t]);
+            json << (t < kMetaTests - 1 ? ", " : "");
+        }
+        json << "}";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getMetadataBenchmarkJSON() {
+    return strdup_cstr(getMetadataBenchmarkJSON_Internal());
+}
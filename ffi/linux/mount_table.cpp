@@ -0,0 +1,255 @@
+#include "include/mount_table.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const int kDefaultTimeoutMs = 500;
+static const size_t kMaxProbeThreads = 8;
+
+// Last statvfs() result of a mount, keyed by mount id.
+struct MountState {
+    MountEntry entry;
+    bool probing = false;        // A worker is (possibly forever) inside statvfs()
+    uint64_t probeStartNs = 0;
+    bool accessible = false;
+    uint64_t updatedNs = 0;      // 0 until the first statvfs() returned
+    uint64_t totalBytes = 0, freeBytes = 0, availableBytes = 0;
+    uint64_t totalInodes = 0, freeInodes = 0;
+};
+
+static mutex mountMutex;
+static condition_variable probeFinished;
+static int mountInfoFd = -1;
+static vector<MountEntry> mountEntries;
+static map<int, MountState> mountStates;
+
+static bool isNetworkFileSystem(const string& type) {
+    static const char* types[] = {
+        "nfs", "nfs4", "cifs", "smb3", "smbfs", "9p", "ceph", "glusterfs",
+        "virtiofs", "afs", "lustre", "fuse", "fuseblk"
+    };
+    for (const char* t : types) {
+        if (type == t) return true;
+    }
+    return type.compare(0, 5, "fuse.") == 0;
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo.
+static string unescapeOctal(const char* s) {
+    string out;
+    for (; *s; s++) {
+        if (s[0] == '\\' && s[1] >= '0' && s[1] <= '7' && s[2] >= '0' && s[2] <= '7' && s[3] >= '0' && s[3] <= '7') {
+            out += (char)((s[1] - '0') * 64 + (s[2] - '0') * 8 + (s[3] - '0'));
+            s += 3;
+        } else {
+            out += *s;
+        }
+    }
+    return out;
+}
+
+// Kernel interfaces mounted as filesystems: no files of the user and no
+// meaningful capacity. Decided by type, not by an anonymous 0:N device
+// number, which btrfs, ZFS and overlayfs roots have as well.
+static bool isPseudoFileSystem(const string& type) {
+    static const char* types[] = {
+        "proc", "sysfs", "cgroup", "cgroup2", "devpts", "devtmpfs", "mqueue", "debugfs",
+        "tracefs", "securityfs", "bpf", "autofs", "pstore", "efivarfs", "configfs", "fusectl",
+        "hugetlbfs", "binfmt_misc", "rpc_pipefs", "nsfs", "selinuxfs", "ramfs"
+    };
+    for (const char* t : types) {
+        if (type == t) return true;
+    }
+    return false;
+}
+
+vector<MountEntry> parseMountInfo(const string& text) {
+    vector<MountEntry> out;
+    istringstream iss(text);
+    string line;
+    char root[4096], mountPoint[4096], options[1024], fsType[256], source[4096];
+    while (getline(iss, line)) {
+        // id parent major:minor root mount-point options [optional...] - type source super-options
+        MountEntry m;
+        if (sscanf(line.c_str(), "%d %d %u:%u %4095s %4095s %1023s",
+                   &m.mountId, &m.parentId, &m.major, &m.minor, root, mountPoint, options) != 7) {
+            continue;
+        }
+        size_t separator = line.find(" - ");
+        if (separator == string::npos) continue;
+        source[0] = '\0';
+        if (sscanf(line.c_str() + separator + 3, "%255s %4095s", fsType, source) < 1) continue;
+        m.root = unescapeOctal(root);
+        m.mountPoint = unescapeOctal(mountPoint);
+        m.fsType = fsType;
+        m.source = unescapeOctal(source);
+        m.readOnly = strncmp(options, "ro", 2) == 0 && (options[2] == ',' || options[2] == '\0');
+        m.network = isNetworkFileSystem(m.fsType);
+        if (!isPseudoFileSystem(m.fsType)) out.push_back(m);
+    }
+    return out;
+}
+
+// Re-reads mountinfo if this is the first call or the kernel flagged a
+// change. Caller holds mountMutex.
+static void refreshMountEntries() {
+    bool changed = false;
+    if (mountInfoFd < 0) {
+        mountInfoFd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+        if (mountInfoFd < 0) return;
+        changed = true;
+    }
+    struct pollfd pfd = {mountInfoFd, POLLPRI, 0};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+        changed = true;
+    }
+    if (!changed) return;
+
+    string text;
+    char buf[16384];
+    lseek(mountInfoFd, 0, SEEK_SET);
+    ssize_t n;
+    while ((n = read(mountInfoFd, buf, sizeof(buf))) > 0) {
+        text.append(buf, (size_t)n);
+    }
+    mountEntries = parseMountInfo(text);
+
+    // Keep the statistics of mounts that are still there.
+    map<int, MountState> states;
+    for (const MountEntry& m : mountEntries) {
+        auto it = mountStates.find(m.mountId);
+        if (it != mountStates.end() && it->second.entry.mountPoint == m.mountPoint) {
+            states[m.mountId] = it->second;
+        }
+        states[m.mountId].entry = m;
+    }
+    mountStates.swap(states);
+}
+
+vector<MountEntry> currentMounts() {
+    lock_guard<mutex> lock(mountMutex);
+    refreshMountEntries();
+    return mountEntries;
+}
+
+// Work shared by the probe threads of one call.
+struct ProbeRound {
+    vector<pair<int, string>> mounts;   // mount id, mount point
+    atomic<size_t> next{0};
+    size_t finished = 0;                 // Guarded by mountMutex
+};
+
+static void probeWorker(shared_ptr<ProbeRound> round) {
+    while (true) {
+        size_t i = round->next.fetch_add(1);
+        if (i >= round->mounts.size()) return;
+        struct statvfs st;
+        bool ok = statvfs(round->mounts[i].second.c_str(), &st) == 0;
+
+        lock_guard<mutex> lock(mountMutex);
+        round->finished++;
+        auto it = mountStates.find(round->mounts[i].first);
+        if (it != mountStates.end()) {
+            MountState& s = it->second;
+            s.probing = false;
+            s.accessible = ok;
+            s.updatedNs = monotonicNanos();
+            if (ok) {
+                s.totalBytes = (uint64_t)st.f_blocks * st.f_frsize;
+                s.freeBytes = (uint64_t)st.f_bfree * st.f_frsize;
+                s.availableBytes = (uint64_t)st.f_bavail * st.f_frsize;
+                s.totalInodes = st.f_files;
+                s.freeInodes = st.f_ffree;
+            }
+        }
+        probeFinished.notify_all();
+    }
+}
+
+//
+// A statvfs() stuck on a dead NFS server cannot be interrupted, so probes
+// run on detached threads and the caller only waits until the deadline.
+// A mount whose previous probe never returned is not probed again (so hung
+// threads do not pile up) and keeps being reported as stale.
+//
+static string getMountTableJSON_Internal(int timeoutMs) {
+    if (timeoutMs <= 0) timeoutMs = kDefaultTimeoutMs;
+    unique_lock<mutex> lock(mountMutex);
+    refreshMountEntries();
+
+    auto round = make_shared<ProbeRound>();
+    uint64_t nowNs = monotonicNanos();
+    for (auto& entry : mountStates) {
+        if (entry.second.probing) continue;
+        entry.second.probing = true;
+        entry.second.probeStartNs = nowNs;
+        round->mounts.emplace_back(entry.first, entry.second.entry.mountPoint);
+    }
+    size_t threads = min(kMaxProbeThreads, round->mounts.size());
+    for (size_t i = 0; i < threads; i++) {
+        thread(probeWorker, round).detach();
+    }
+    probeFinished.wait_for(lock, chrono::milliseconds(timeoutMs),
+                           [&] { return round->finished == round->mounts.size(); });
+
+    // Mounts no worker got to (all of them stuck) go back to the pool.
+    size_t claimed = round->next.exchange(round->mounts.size());
+    for (size_t i = claimed; i < round->mounts.size(); i++) {
+        auto it = mountStates.find(round->mounts[i].first);
+        if (it != mountStates.end()) it->second.probing = false;
+    }
+
+    nowNs = monotonicNanos();
+    ostringstream json;
+    json << "{ \"mounts\": [";
+    bool first = true;
+    for (const MountEntry& m : mountEntries) {
+        const MountState& s = mountStates[m.mountId];
+        bool stale = s.probing && nowNs - s.probeStartNs >= (uint64_t)timeoutMs * 1000000ULL;
+        if (!first) json << ", ";
+        first = false;
+        json << "{";
+        json << "\"mountId\": " << m.mountId << ", ";
+        json << "\"device\": \"" << m.major << ":" << m.minor << "\", ";
+        json << "\"source\": \"" << jsonEscape(m.source) << "\", ";
+        json << "\"mountPoint\": \"" << jsonEscape(m.mountPoint) << "\", ";
+        json << "\"root\": \"" << jsonEscape(m.root) << "\", ";
+        json << "\"fileSystemType\": \"" << jsonEscape(m.fsType) << "\", ";
+        json << "\"readOnly\": " << (m.readOnly ? "true" : "false") << ", ";
+        json << "\"network\": " << (m.network ? "true" : "false") << ", ";
+        json << "\"totalBytes\": " << s.totalBytes << ", ";
+        json << "\"freeBytes\": " << s.freeBytes << ", ";
+        json << "\"availableBytes\": " << s.availableBytes << ", ";
+        json << "\"totalInodes\": " << s.totalInodes << ", ";
+        json << "\"freeInodes\": " << s.freeInodes << ", ";
+        json << "\"accessible\": " << (s.accessible ? "true" : "false") << ", ";
+        json << "\"stale\": " << (stale ? "true" : "false") << ", ";
+        json << "\"ageMs\": " << (s.updatedNs ? (nowNs - s.updatedNs) / 1000000ULL : 0);
+        json << "}";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getMountTableJSON(int timeoutMs) {
+    return strdup_cstr(getMountTableJSON_Internal(timeoutMs));
+}
@@ -0,0 +1,237 @@
+#include "include/network_activity.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Raw counters of one /proc/net/dev line.
+struct InterfaceCounters {
+    uint64_t rxBytes, rxPackets, rxErrors, rxDrops;
+    uint64_t txBytes, txPackets, txErrors, txDrops;
+};
+
+// Attributes from /sys/class/net/<name>, kept until a link event.
+struct InterfaceInfo {
+    int ifIndex = 0;
+    string operState;
+    string macAddress;
+    int mtu = 0;
+    int64_t speedMbps = -1;
+    bool loopback = false;
+    bool wireless = false;
+    bool virtualDevice = false;
+};
+
+static mutex networkMutex;
+static map<string, InterfaceCounters> previousCounters;
+static uint64_t previousNs = 0;
+static vector<NetworkActivity> latestActivity;
+static map<string, InterfaceInfo> interfaceInfo;
+static bool interfacesValid = false;
+static int linkFd = -2;            // -2: not opened yet, -1: unavailable
+
+static string readAttribute(const string& path) {
+    string value;
+    if (!readFile(path.c_str(), value)) return "";
+    size_t end = value.find_last_not_of(" \n\t");
+    return end == string::npos ? "" : value.substr(0, end + 1);
+}
+
+static InterfaceInfo describeInterface(const string& name) {
+    const string base = "/sys/class/net/" + name;
+    InterfaceInfo info;
+    info.ifIndex = atoi(readAttribute(base + "/ifindex").c_str());
+    info.operState = readAttribute(base + "/operstate");
+    info.macAddress = readAttribute(base + "/address");
+    info.mtu = atoi(readAttribute(base + "/mtu").c_str());
+    // Reading speed fails with EINVAL while the link is down.
+    string speed = readAttribute(base + "/speed");
+    info.speedMbps = speed.empty() ? -1 : strtoll(speed.c_str(), nullptr, 10);
+    if (info.speedMbps <= 0) info.speedMbps = -1;
+    info.loopback = readAttribute(base + "/type") == "772"; // ARPHRD_LOOPBACK
+    info.wireless = access((base + "/wireless").c_str(), F_OK) == 0 ||
+                    access((base + "/phy80211").c_str(), F_OK) == 0;
+    info.virtualDevice = access((base + "/device").c_str(), F_OK) != 0;
+    return info;
+}
+
+static int openLinkSocket() {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads pending rtnetlink messages. Returns true on any link change (or
+// an overrun, after which the state is unknown).
+static bool drainLinkEvents(int fd) {
+    char buf[16384];
+    bool changed = false;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+        if (n < 0) {
+            if (errno == ENOBUFS) changed = true;
+            if (errno == EINTR || errno == ENOBUFS) continue;
+            break;
+        }
+        int len = (int)n;
+        for (struct nlmsghdr* nh = (struct nlmsghdr*)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == RTM_NEWLINK || nh->nlmsg_type == RTM_DELLINK) changed = true;
+        }
+    }
+    return changed;
+}
+
+// Caller holds networkMutex.
+static const InterfaceInfo& infoFor(const string& name) {
+    auto it = interfaceInfo.find(name);
+    if (it != interfaceInfo.end()) return it->second;
+    return interfaceInfo[name] = describeInterface(name);
+}
+
+static void sampleNetDev(uint64_t nowNs) {
+    string text;
+    if (!readFile("/proc/net/dev", text)) return;
+
+    map<string, InterfaceCounters> current;
+    istringstream iss(text);
+    string line;
+    while (getline(iss, line)) {
+        // "  eth0: rx_bytes packets errs drop fifo frame compressed multicast tx_bytes packets errs drop ..."
+        size_t colon = line.find(':');
+        if (colon == string::npos) continue; // Two header lines
+        size_t start = line.find_first_not_of(' ');
+        string name = line.substr(start, colon - start);
+        InterfaceCounters c;
+        unsigned long long f[12];
+        if (sscanf(line.c_str() + colon + 1, "%llu %llu %llu %llu %*u %*u %*u %*u %llu %llu %llu %llu",
+                   &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7]) != 8) {
+            continue;
+        }
+        c.rxBytes = f[0]; c.rxPackets = f[1]; c.rxErrors = f[2]; c.rxDrops = f[3];
+        c.txBytes = f[4]; c.txPackets = f[5]; c.txErrors = f[6]; c.txDrops = f[7];
+        current[name] = c;
+    }
+
+    lock_guard<mutex> lock(networkMutex);
+    if (linkFd == -2) linkFd = openLinkSocket();
+    if (linkFd >= 0) {
+        if (drainLinkEvents(linkFd)) interfacesValid = false;
+    } else if (current.size() != previousCounters.size()) {
+        interfacesValid = false; // No rtnetlink: at least notice added/removed links
+    }
+    if (!interfacesValid) {
+        interfaceInfo.clear();
+        interfacesValid = true;
+    }
+
+    const double elapsedSec = previousNs ? (double)(nowNs - previousNs) / 1e9 : 0.0;
+    vector<NetworkActivity> activity;
+    for (const auto& entry : current) {
+        const InterfaceCounters& c = entry.second;
+        const InterfaceInfo& info = infoFor(entry.first);
+        NetworkActivity a{};
+        a.interface = entry.first;
+        a.ifIndex = info.ifIndex;
+        a.operState = info.operState;
+        a.macAddress = info.macAddress;
+        a.mtu = info.mtu;
+        a.speedMbps = info.speedMbps;
+        a.loopback = info.loopback;
+        a.wireless = info.wireless;
+        a.virtualDevice = info.virtualDevice;
+        a.rxBytes = c.rxBytes;
+        a.txBytes = c.txBytes;
+        a.rxErrors = c.rxErrors;
+        a.txErrors = c.txErrors;
+        a.rxDrops = c.rxDrops;
+        a.txDrops = c.txDrops;
+        auto prev = previousCounters.find(entry.first);
+        // Counters restart when an interface is recreated under the same name.
+        if (prev != previousCounters.end() && elapsedSec > 0 &&
+            c.rxBytes >= prev->second.rxBytes && c.txBytes >= prev->second.txBytes) {
+            const InterfaceCounters& p = prev->second;
+            a.rxBytesPerSec = (double)(c.rxBytes - p.rxBytes) / elapsedSec;
+            a.txBytesPerSec = (double)(c.txBytes - p.txBytes) / elapsedSec;
+            a.rxPacketsPerSec = (double)(c.rxPackets - p.rxPackets) / elapsedSec;
+            a.txPacketsPerSec = (double)(c.txPackets - p.txPackets) / elapsedSec;
+            a.rxErrorsPerSec = (double)(c.rxErrors - p.rxErrors) / elapsedSec;
+            a.txErrorsPerSec = (double)(c.txErrors - p.txErrors) / elapsedSec;
+            a.rxDropsPerSec = (double)(c.rxDrops - p.rxDrops) / elapsedSec;
+            a.txDropsPerSec = (double)(c.txDrops - p.txDrops) / elapsedSec;
+        }
+        activity.push_back(a);
+    }
+    previousCounters.swap(current);
+    previousNs = nowNs;
+    latestActivity.swap(activity);
+}
+
+vector<NetworkActivity> latestNetworkActivity() {
+    registerSampler("netdev", sampleNetDev);
+    lock_guard<mutex> lock(networkMutex);
+    return latestActivity;
+}
+
+static string getNetworkActivityJSON_Internal() {
+    vector<NetworkActivity> activity = latestNetworkActivity();
+    ostringstream json;
+    json << "{ \"network_activity\": [";
+    for (size_t i = 0; i < activity.size(); i++) {
+        const NetworkActivity& a = activity[i];
+        json << "{";
+        json << "\"interface\": \"" << jsonEscape(a.interface) << "\", ";
+        json << "\"ifIndex\": " << a.ifIndex << ", ";
+        json << "\"operState\": \"" << jsonEscape(a.operState) << "\", ";
+        json << "\"macAddress\": \"" << jsonEscape(a.macAddress) << "\", ";
+        json << "\"mtu\": " << a.mtu << ", ";
+        json << "\"speedMbps\": " << a.speedMbps << ", ";
+        json << "\"loopback\": " << (a.loopback ? "true" : "false") << ", ";
+        json << "\"wireless\": " << (a.wireless ? "true" : "false") << ", ";
+        json << "\"virtual\": " << (a.virtualDevice ? "true" : "false") << ", ";
+        json << "\"rxBytesPerSec\": " << a.rxBytesPerSec << ", ";
+        json << "\"txBytesPerSec\": " << a.txBytesPerSec << ", ";
+        json << "\"rxPacketsPerSec\": " << a.rxPacketsPerSec << ", ";
+        json << "\"txPacketsPerSec\": " << a.txPacketsPerSec << ", ";
+        json << "\"rxErrorsPerSec\": " << a.rxErrorsPerSec << ", ";
+        json << "\"txErrorsPerSec\": " << a.txErrorsPerSec << ", ";
+        json << "\"rxDropsPerSec\": " << a.rxDropsPerSec << ", ";
+        json << "\"txDropsPerSec\": " << a.txDropsPerSec << ", ";
+        json << "\"rxBytes\": " << a.rxBytes << ", ";
+        json << "\"txBytes\": " << a.txBytes << ", ";
+        json << "\"rxErrors\": " << a.rxErrors << ", ";
+        json << "\"txErrors\": " << a.txErrors << ", ";
+        json << "\"rxDrops\": " << a.rxDrops << ", ";
+        json << "\"txDrops\": " << a.txDrops;
+        json << "}";
+        if (i < activity.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getNetworkActivityJSON() {
+    return strdup_cstr(getNetworkActivityJSON_Internal());
+}
@@ -0,0 +1,281 @@
+#include "include/open_files.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// TCP states as numbered in include/net/tcp_states.h.
+static const char* tcpStateName(unsigned state) {
+    static const char* names[] = {
+        "UNKNOWN", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2",
+        "TIME_WAIT", "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING", "NEW_SYN_RECV"
+    };
+    return state < sizeof(names) / sizeof(names[0]) ? names[state] : "UNKNOWN";
+}
+
+// Decodes the kernel's hex address ("0100007F" or 32 hex digits for IPv6).
+static string decodeAddress(const char* hex, size_t len) {
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (len == 8) {
+        struct in_addr addr;
+        addr.s_addr = (uint32_t)strtoul(string(hex, 8).c_str(), nullptr, 16);
+        inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+    } else if (len == 32) {
+        // Four 32-bit words, each in host byte order.
+        struct in6_addr addr;
+        uint32_t words[4];
+        for (int i = 0; i < 4; i++) {
+            words[i] = (uint32_t)strtoul(string(hex + i * 8, 8).c_str(), nullptr, 16);
+        }
+        memcpy(&addr, words, sizeof(words));
+        inet_ntop(AF_INET6, &addr, buf, sizeof(buf));
+    }
+    return buf;
+}
+
+// Splits "ADDR:PORT" into a printable address and port.
+static void decodeEndpoint(const char* field, string& address, int& port) {
+    const char* colon = strchr(field, ':');
+    if (!colon) {
+        address.clear();
+        port = 0;
+        return;
+    }
+    address = decodeAddress(field, (size_t)(colon - field));
+    port = (int)strtol(colon + 1, nullptr, 16);
+}
+
+static void readInetTable(const string& path, const char* protocol, bool udp, SocketTable& table) {
+    string text;
+    if (!readFile(path.c_str(), text)) return;
+    istringstream iss(text);
+    string line;
+    getline(iss, line); // Header
+    char local[64], remote[64];
+    unsigned state;
+    unsigned long long inode;
+    while (getline(iss, line)) {
+        // sl local_address rem_address st tx:rx tr:when retrnsmt uid timeout inode
+        if (sscanf(line.c_str(), " %*s %63s %63s %x %*s %*s %*s %*s %*s %llu",
+                   local, remote, &state, &inode) != 4 || inode == 0) {
+            continue;
+        }
+        SocketEntry entry;
+        entry.protocol = protocol;
+        decodeEndpoint(local, entry.localAddress, entry.localPort);
+        decodeEndpoint(remote, entry.remoteAddress, entry.remotePort);
+        if (udp) {
+            // Unconnected UDP sockets report TCP_CLOSE.
+            entry.state = state == 1 ? "ESTABLISHED" : "UNCONN";
+        } else {
+            entry.state = tcpStateName(state);
+        }
+        table[inode] = entry;
+    }
+}
+
+static void readUnixTable(const string& path, SocketTable& table) {
+    string text;
+    if (!readFile(path.c_str(), text)) return;
+    istringstream iss(text);
+    string line;
+    getline(iss, line); // Header
+    unsigned long flags;
+    unsigned state;
+    unsigned long long inode;
+    while (getline(iss, line)) {
+        // Num RefCount Protocol Flags Type St Inode [Path]
+        int consumed = 0;
+        if (sscanf(line.c_str(), "%*s %*s %*s %lx %*s %x %llu%n",
+                   &flags, &state, &inode, &consumed) != 3 || inode == 0) {
+            continue;
+        }
+        SocketEntry entry;
+        entry.protocol = "unix";
+        entry.localPort = entry.remotePort = 0;
+        size_t pathStart = line.find_first_not_of(' ', (size_t)consumed);
+        if (pathStart != string::npos) entry.path = line.substr(pathStart);
+        if (flags & 0x10000) {          // __SO_ACCEPTCON
+            entry.state = "LISTEN";
+        } else if (state == 3) {        // SS_CONNECTED
+            entry.state = "ESTABLISHED";
+        } else {
+            entry.state = "UNCONN";
+        }
+        table[inode] = entry;
+    }
+}
+
+SocketTable readSocketTable(const char* procRoot) {
+    SocketTable table;
+    string net = string(procRoot) + "/net/";
+    readInetTable(net + "tcp", "tcp", false, table);
+    readInetTable(net + "tcp6", "tcp6", false, table);
+    readInetTable(net + "udp", "udp", true, table);
+    readInetTable(net + "udp6", "udp6", true, table);
+    readUnixTable(net + "unix", table);
+    return table;
+}
+
+SocketTable readTcpSocketTable(const char* procRoot) {
+    SocketTable table;
+    string net = string(procRoot) + "/net/";
+    readInetTable(net + "tcp", "tcp", false, table);
+    readInetTable(net + "tcp6", "tcp6", false, table);
+    return table;
+}
+
+const char* fdKindName(FdKind kind) {
+    switch (kind) {
+        case FdKind::File: return "file";
+        case FdKind::Socket: return "socket";
+        case FdKind::Pipe: return "pipe";
+        case FdKind::AnonInode: return "anon_inode";
+        case FdKind::EventFd: return "eventfd";
+        default: return "other";
+    }
+}
+
+// Extracts the number from "socket:[1234]" / "pipe:[1234]".
+static uint64_t bracketInode(const char* target) {
+    const char* open = strchr(target, '[');
+    return open ? strtoull(open + 1, nullptr, 10) : 0;
+}
+
+bool listProcessFds(int pidFd, vector<OpenFdEntry>& out) {
+    out.clear();
+    int fd = openat(pidFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return false;
+    }
+    char target[4096];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        ssize_t len = readlinkat(dirfd(dir), entry->d_name, target, sizeof(target) - 1);
+        if (len <= 0) continue; // Closed since readdir()
+        target[len] = '\0';
+
+        OpenFdEntry item;
+        item.fd = atoi(entry->d_name);
+        item.target.assign(target, (size_t)len);
+        item.inode = 0;
+        if (target[0] == '/') {
+            item.kind = FdKind::File;
+        } else if (strncmp(target, "socket:", 7) == 0) {
+            item.kind = FdKind::Socket;
+            item.inode = bracketInode(target);
+        } else if (strncmp(target, "pipe:", 5) == 0) {
+            item.kind = FdKind::Pipe;
+            item.inode = bracketInode(target);
+        } else if (strcmp(target, "anon_inode:[eventfd]") == 0) {
+            item.kind = FdKind::EventFd;
+        } else if (strncmp(target, "anon_inode:", 11) == 0) {
+            item.kind = FdKind::AnonInode;
+        } else {
+            item.kind = FdKind::Other;
+        }
+        out.push_back(item);
+    }
+    closedir(dir);
+    return true;
+}
+
+// Appends one process to the JSON array. Returns false if it was skipped.
+static bool appendProcessJSON(ostringstream& json, int procFd, const char* pidName,
+                              const SocketTable& sockets, vector<OpenFdEntry>& fds, bool first) {
+    int pidFd = openat(procFd, pidName, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pidFd < 0) return false;
+    string comm;
+    readFileAt(pidFd, "comm", comm);
+    if (!comm.empty() && comm.back() == '\n') comm.pop_back();
+    bool readable = listProcessFds(pidFd, fds);
+    close(pidFd);
+    if (!readable) return false;
+
+    if (!first) json << ", ";
+    json << "{\"pid\": " << pidName << ", ";
+    json << "\"name\": \"" << jsonEscape(comm) << "\", ";
+    json << "\"files\": [";
+    for (size_t i = 0; i < fds.size(); i++) {
+        const OpenFdEntry& f = fds[i];
+        json << "{\"fd\": " << f.fd << ", ";
+        json << "\"type\": \"" << fdKindName(f.kind) << "\", ";
+        json << "\"target\": \"" << jsonEscape(f.target) << "\"}";
+        if (i < fds.size() - 1)
+            json << ", ";
+    }
+    json << "], \"sockets\": [";
+    bool firstSocket = true;
+    for (const OpenFdEntry& f : fds) {
+        if (f.kind != FdKind::Socket) continue;
+        auto it = sockets.find(f.inode);
+        if (it == sockets.end()) continue; // netlink, packet, ... sockets
+        const SocketEntry& s = it->second;
+        if (!firstSocket) json << ", ";
+        firstSocket = false;
+        json << "{\"fd\": " << f.fd << ", ";
+        json << "\"protocol\": \"" << s.protocol << "\", ";
+        json << "\"state\": \"" << s.state << "\", ";
+        json << "\"localAddress\": \"" << s.localAddress << "\", ";
+        json << "\"localPort\": " << s.localPort << ", ";
+        json << "\"remoteAddress\": \"" << s.remoteAddress << "\", ";
+        json << "\"remotePort\": " << s.remotePort << ", ";
+        json << "\"path\": \"" << jsonEscape(s.path) << "\"}";
+    }
+    json << "]}";
+    return true;
+}
+
+//
+// Builds the inventory. The socket table is parsed once up front, so the
+// whole sweep costs O(fds + sockets) regardless of the process count.
+//
+static string getOpenFilesJSON_Internal(int pid) {
+    int procFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) {
+        return "{ \"open_files\": 0 }";
+    }
+    SocketTable sockets = readSocketTable();
+    vector<OpenFdEntry> fds;
+    ostringstream json;
+    json << "{ \"open_files\": [";
+    if (pid > 0) {
+        appendProcessJSON(json, procFd, to_string(pid).c_str(), sockets, fds, true);
+        close(procFd);
+    } else {
+        DIR* dir = fdopendir(procFd);
+        if (!dir) {
+            close(procFd);
+            return "{ \"open_files\": 0 }";
+        }
+        bool first = true;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            if (appendProcessJSON(json, procFd, entry->d_name, sockets, fds, first)) {
+                first = false;
+            }
+        }
+        closedir(dir);
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getOpenFilesJSON(int pid) {
+    return strdup_cstr(getOpenFilesJSON_Internal(pid));
+}
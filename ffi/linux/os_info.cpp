@@ -0,0 +1,155 @@
+#include "include/os_info.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <pwd.h>
+#include <sys/sysinfo.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Fields that cannot change while the app runs. Host name and uptime are
+// read on every call.
+struct StaticOsInfo {
+    string osName;
+    string osVersion;
+    string buildNumber;
+    string kernelVersion;
+    bool is64Bit;
+    string deviceName;
+    string userName;
+    string locale;
+};
+
+static mutex osMutex;
+static StaticOsInfo cachedInfo;
+static bool cacheValid = false;
+
+// Value of KEY in an os-release / machine-info style file, unquoted.
+static string shellVariable(const string& text, const char* key) {
+    const size_t keyLen = strlen(key);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == string::npos) eol = text.size();
+        if (text.compare(pos, keyLen, key) == 0 && pos + keyLen < eol && text[pos + keyLen] == '=') {
+            string value = text.substr(pos + keyLen + 1, eol - pos - keyLen - 1);
+            if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'') && value.back() == value[0]) {
+                value = value.substr(1, value.size() - 2);
+            }
+            return value;
+        }
+        pos = eol + 1;
+    }
+    return "";
+}
+
+// "en_US.UTF-8@euro" -> "en_US", matching AppleLocale.
+static string localeName() {
+    const char* vars[] = {"LC_ALL", "LC_MESSAGES", "LANG"};
+    for (const char* var : vars) {
+        const char* value = getenv(var);
+        if (value && *value) {
+            string locale = value;
+            return locale.substr(0, locale.find_first_of(".@"));
+        }
+    }
+    return "Unknown";
+}
+
+static string userName() {
+    struct passwd pw;
+    struct passwd* result = nullptr;
+    char buf[1024];
+    if (getpwuid_r(geteuid(), &pw, buf, sizeof(buf), &result) == 0 && result) return pw.pw_name;
+    return "Unknown";
+}
+
+static string hostName() {
+    char name[256];
+    if (gethostname(name, sizeof(name)) != 0) return "Unknown";
+    name[sizeof(name) - 1] = '\0';
+    return name;
+}
+
+static StaticOsInfo readStaticOsInfo() {
+    StaticOsInfo info;
+    string osRelease;
+    if (!readFile("/etc/os-release", osRelease)) readFile("/usr/lib/os-release", osRelease);
+    info.osName = shellVariable(osRelease, "NAME");
+    if (info.osName.empty()) info.osName = "Linux";
+    info.osVersion = shellVariable(osRelease, "VERSION_ID");
+    if (info.osVersion.empty()) info.osVersion = "Unknown";
+
+    struct utsname uts;
+    bool haveUname = uname(&uts) == 0;
+    info.kernelVersion = haveUname ? uts.release : "Unknown";
+    string machine = haveUname ? uts.machine : "";
+    info.is64Bit = machine.find("64") != string::npos || machine == "s390x";
+    // Rolling distributions only have BUILD_ID; otherwise the kernel build.
+    info.buildNumber = shellVariable(osRelease, "BUILD_ID");
+    if (info.buildNumber.empty()) info.buildNumber = haveUname ? uts.version : "Unknown";
+
+    // The user-facing machine name set with hostnamectl, like ComputerName.
+    string machineInfo;
+    if (readFile("/etc/machine-info", machineInfo)) info.deviceName = shellVariable(machineInfo, "PRETTY_HOSTNAME");
+    if (info.deviceName.empty()) info.deviceName = hostName();
+
+    info.userName = userName();
+    info.locale = localeName();
+    return info;
+}
+
+// "X Days Y Hours" as on macOS.
+static string systemUptime() {
+    struct sysinfo si;
+    if (sysinfo(&si) != 0) return "Unknown";
+    long diff = si.uptime;
+    long days = diff / (3600 * 24);
+    diff %= (3600 * 24);
+    long hours = diff / 3600;
+    ostringstream oss;
+    if (days > 0) {
+        oss << days << " Days " << hours << " Hours";
+    } else {
+        oss << hours << " Hours";
+    }
+    return oss.str();
+}
+
+string buildOsInfoJson(bool cached) {
+    StaticOsInfo info;
+    if (cached) {
+        lock_guard<mutex> lock(osMutex);
+        if (!cacheValid) {
+            cachedInfo = readStaticOsInfo();
+            cacheValid = true;
+        }
+        info = cachedInfo;
+    } else {
+        info = readStaticOsInfo();
+    }
+    ostringstream json;
+    json << "{\n";
+    json << "  \"osName\": \"" << jsonEscape(info.osName) << "\",\n";
+    json << "  \"osVersion\": \"" << jsonEscape(info.osVersion) << "\",\n";
+    json << "  \"buildNumber\": \"" << jsonEscape(info.buildNumber) << "\",\n";
+    json << "  \"kernelVersion\": \"" << jsonEscape(info.kernelVersion) << "\",\n";
+    json << "  \"is64Bit\": " << (info.is64Bit ? "true" : "false") << ",\n";
+    json << "  \"systemUptime\": \"" << systemUptime() << "\",\n";
+    json << "  \"deviceName\": \"" << jsonEscape(info.deviceName) << "\",\n";
+    json << "  \"hostName\": \"" << jsonEscape(hostName()) << "\",\n";
+    json << "  \"userName\": \"" << jsonEscape(info.userName) << "\",\n";
+    json << "  \"locale\": \"" << jsonEscape(info.locale) << "\"\n";
+    json << "}";
+    return json.str();
+}
+
+char* getOsInfoJson() {
+    return strdup_cstr(buildOsInfoJson(true));
+}
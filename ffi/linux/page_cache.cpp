@@ -0,0 +1,257 @@
+#include "include/page_cache.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+// cachestat(2) arrived in Linux 6.5; older headers do not know it.
+#ifndef __NR_cachestat
+#define __NR_cachestat 451
+#endif
+
+struct CachestatRange {
+    uint64_t off;
+    uint64_t len;
+};
+
+struct Cachestat {
+    uint64_t nrCache;
+    uint64_t nrDirty;
+    uint64_t nrWriteback;
+    uint64_t nrEvicted;
+    uint64_t nrRecentlyEvicted;
+};
+
+// Largest mapping held at once by the mincore() fallback.
+static const size_t kMincoreWindow = 64 << 20;
+static const size_t kMaxFiles = 500000;
+
+struct CachedFile {
+    string path;
+    uint64_t size;
+    uint64_t residentBytes;
+    uint64_t dirtyBytes;
+};
+
+static atomic<bool> cachestatAvailable(true);
+
+static bool residencyByCachestat(int fd, uint64_t& resident, uint64_t& dirty) {
+    CachestatRange range = {0, 0}; // len 0 means "to the end of the file"
+    Cachestat cs;
+    if (syscall(__NR_cachestat, fd, &range, &cs, 0) != 0) {
+        if (errno == ENOSYS) cachestatAvailable = false;
+        return false;
+    }
+    resident = cs.nrCache * (uint64_t)sysconf(_SC_PAGESIZE);
+    dirty = cs.nrDirty * (uint64_t)sysconf(_SC_PAGESIZE);
+    return true;
+}
+
+// Maps the file one window at a time; mapping and mincore() never read the
+// file, so the measurement leaves the cache as it found it.
+static bool residencyByMincore(int fd, uint64_t size, vector<unsigned char>& vec, uint64_t& resident) {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    resident = 0;
+    for (uint64_t offset = 0; offset < size; offset += kMincoreWindow) {
+        size_t length = (size_t)min<uint64_t>(kMincoreWindow, size - offset);
+        void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, (off_t)offset);
+        if (map == MAP_FAILED) return false;
+        size_t pages = (length + page - 1) / page;
+        vec.resize(pages);
+        bool ok = mincore(map, length, vec.data()) == 0;
+        munmap(map, length);
+        if (!ok) return false;
+        for (size_t i = 0; i < pages; i++) resident += vec[i] & 1;
+    }
+    resident *= page;
+    return true;
+}
+
+// Measurement method counts of one walk.
+struct MethodCounts {
+    uint64_t cachestat = 0;
+    uint64_t mincore = 0;
+};
+
+static bool measureFile(int dirFd, const char* name, const string& path, uint64_t size,
+                        vector<unsigned char>& vec, vector<CachedFile>& out, MethodCounts& methods) {
+    int fd = openat(dirFd, name, O_RDONLY | O_NOATIME | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0 && errno == EPERM) fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) return false;
+    uint64_t resident = 0, dirty = 0;
+    bool ok = cachestatAvailable && residencyByCachestat(fd, resident, dirty);
+    if (ok) {
+        methods.cachestat++;
+    } else if ((ok = residencyByMincore(fd, size, vec, resident))) {
+        methods.mincore++;
+    }
+    close(fd);
+    if (ok && resident > 0) out.push_back(CachedFile{path, size, resident, dirty});
+    return ok;
+}
+
+// Counters are updated as the walk goes; the files and method counts are
+// published when it ends.
+static mutex cacheScanMutex;
+static vector<CachedFile> cachedFiles;
+static MethodCounts scanMethods;
+static string cacheScanError;
+static atomic<bool> cacheScanRunning(false);
+static atomic<bool> cacheScanCancel(false);
+static atomic<bool> cacheScanTruncated(false);
+static atomic<uint64_t> filesScanned(0);
+static atomic<uint64_t> bytesScanned(0);
+static atomic<uint64_t> scanErrors(0);
+static atomic<uint64_t> cacheScanStartNs(0);
+static atomic<uint64_t> cacheScanEndNs(0);
+
+static void pageCacheThread(string root, struct stat st) {
+    vector<CachedFile> cached;
+    vector<unsigned char> vec;
+    MethodCounts methods;
+    bool truncated = false;
+
+    if (S_ISREG(st.st_mode)) {
+        filesScanned = 1;
+        bytesScanned = (uint64_t)st.st_size;
+        if (!measureFile(AT_FDCWD, root.c_str(), root, (uint64_t)st.st_size, vec, cached, methods)) scanErrors++;
+    } else {
+        // Stay on the root's filesystem, like du -x: no /proc, /sys or network mounts.
+        const dev_t rootDev = st.st_dev;
+        vector<string> stack = {root};
+        while (!stack.empty() && !truncated && !cacheScanCancel) {
+            string dirPath = stack.back();
+            stack.pop_back();
+            DIR* dir = opendir(dirPath.c_str());
+            if (!dir) {
+                scanErrors++;
+                continue;
+            }
+            if (dirPath.back() != '/') dirPath += '/';
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr && !cacheScanCancel) {
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                if (S_ISDIR(st.st_mode)) {
+                    if (st.st_dev == rootDev) stack.push_back(dirPath + name);
+                } else if (S_ISREG(st.st_mode) && st.st_size > 0) {
+                    if (filesScanned == kMaxFiles) {
+                        truncated = true;
+                        break;
+                    }
+                    filesScanned++;
+                    bytesScanned += (uint64_t)st.st_size;
+                    if (!measureFile(dirfd(dir), name, dirPath + name, (uint64_t)st.st_size, vec, cached, methods)) scanErrors++;
+                }
+            }
+            closedir(dir);
+        }
+    }
+    sort(cached.begin(), cached.end(),
+         [](const CachedFile& a, const CachedFile& b) { return a.residentBytes > b.residentBytes; });
+
+    {
+        lock_guard<mutex> lock(cacheScanMutex);
+        cachedFiles.swap(cached);
+        scanMethods = methods;
+        cacheScanError = cacheScanCancel ? "cancelled" : "";
+    }
+    // A cancelled walk keeps what it measured, flagged like a capped one.
+    cacheScanTruncated = truncated || cacheScanCancel;
+    cacheScanEndNs = monotonicNanos();
+    cacheScanRunning = false;
+}
+
+bool startPageCacheScan(const char* path) {
+    // Walking a whole filesystem takes seconds, so there is no implicit default.
+    if (!path || !*path) return false;
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+
+    bool expected = false;
+    if (!cacheScanRunning.compare_exchange_strong(expected, true)) return false;
+    {
+        lock_guard<mutex> lock(cacheScanMutex);
+        cachedFiles.clear();
+        scanMethods = MethodCounts();
+        cacheScanError.clear();
+    }
+    cacheScanCancel = false;
+    cacheScanTruncated = false;
+    filesScanned = bytesScanned = scanErrors = 0;
+    cacheScanStartNs = monotonicNanos();
+    cacheScanEndNs = 0;
+    thread(pageCacheThread, string(path), st).detach();
+    return true;
+}
+
+void cancelPageCacheScan() {
+    cacheScanCancel = true;
+}
+
+static string getPageCacheJSON_Internal(size_t topN) {
+    uint64_t endNs = cacheScanEndNs;
+    uint64_t elapsedMs = cacheScanStartNs ? ((endNs ? endNs : monotonicNanos()) - cacheScanStartNs) / 1000000ULL : 0;
+    string meminfo;
+    readFile("/proc/meminfo", meminfo);
+    ostringstream json;
+    json << "{ \"running\": " << (cacheScanRunning ? "true" : "false") << ", ";
+    json << "\"systemCached\": " << findKbField(meminfo, "Cached") * 1024 << ", ";
+    json << "\"filesScanned\": " << filesScanned << ", ";
+    json << "\"bytesScanned\": " << bytesScanned << ", ";
+    json << "\"errors\": " << scanErrors << ", ";
+    json << "\"truncated\": " << (cacheScanTruncated ? "true" : "false") << ", ";
+    json << "\"elapsedMs\": " << elapsedMs << ", ";
+
+    lock_guard<mutex> lock(cacheScanMutex);
+    uint64_t residentTotal = 0, dirtyTotal = 0;
+    for (const CachedFile& f : cachedFiles) {
+        residentTotal += f.residentBytes;
+        dirtyTotal += f.dirtyBytes;
+    }
+    const MethodCounts& methods = scanMethods;
+    const char* method = methods.mincore == 0 ? (methods.cachestat ? "cachestat" : "none")
+                                              : (methods.cachestat ? "mixed" : "mincore");
+    json << "\"error\": \"" << jsonEscape(cacheScanError) << "\", ";
+    json << "\"method\": \"" << method << "\", ";
+    json << "\"cachestatFiles\": " << methods.cachestat << ", ";
+    json << "\"mincoreFiles\": " << methods.mincore << ", ";
+    json << "\"residentBytes\": " << residentTotal << ", ";
+    json << "\"dirtyBytes\": " << dirtyTotal << ", ";
+    json << "\"files\": [";
+    size_t shown = min(topN, cachedFiles.size());
+    for (size_t i = 0; i < shown; i++) {
+        const CachedFile& f = cachedFiles[i];
+        json << "{";
+        json << "\"path\": \"" << jsonEscape(f.path) << "\", ";
+        json << "\"size\": " << f.size << ", ";
+        json << "\"residentBytes\": " << f.residentBytes << ", ";
+        json << "\"residentPercent\": " << (f.size ? min(100.0, (double)f.residentBytes * 100.0 / (double)f.size) : 0.0) << ", ";
+        json << "\"dirtyBytes\": " << f.dirtyBytes;
+        json << "}";
+        if (i < shown - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getPageCacheJSON(int topN) {
+    return strdup_cstr(getPageCacheJSON_Internal(topN > 0 ? (size_t)topN : 50));
+}
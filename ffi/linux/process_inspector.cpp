@@ -0,0 +1,383 @@
+#include "include/process_inspector.h"
+#include "include/proc_reader.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+using namespace std;
+
+// Threads beyond this are still counted, but not reported individually.
+static const int kMaxInspectThreads = 64;
+
+// /proc/[pid]/maps is walked at most this often; it takes mmap_lock in the
+// target, which would be unkind at 100 Hz on a large process.
+static const uint64_t kMapsIntervalNs = 250000000ULL;
+
+struct ThreadSample {
+    int tid;
+    char name[16];
+    double cpuUsage;
+    double minorFaultsPerSec;
+    double majorFaultsPerSec;
+};
+
+// One ring slot. Fixed size so the ring can be allocated up front.
+struct InspectSample {
+    uint64_t seq;
+    uint64_t timestampMs;      // CLOCK_MONOTONIC
+    double cpuUsage;
+    uint64_t rss;              // KB
+    double minorFaultsPerSec;
+    double majorFaultsPerSec;
+    double readBytesPerSec;
+    double writeBytesPerSec;
+    int fdCount;
+    uint64_t heap;             // Mapped sizes from /proc/[pid]/maps, KB
+    uint64_t stack;
+    uint64_t anon;
+    uint64_t fileBacked;
+    int threadCount;
+    int reportedThreads;
+    ThreadSample threads[kMaxInspectThreads];
+};
+
+struct ThreadCounters {
+    uint64_t cpuTicks;
+    uint64_t minorFaults;
+    uint64_t majorFaults;
+};
+
+struct InspectorSession {
+    int pid;
+    int pidFd;
+    int timerFd;
+    int stopFd;
+    thread worker;
+    atomic<bool> alive;
+
+    mutex ringMutex;
+    vector<InspectSample> ring;
+    InspectSample scratch;     // Filled outside the lock, then copied in
+    uint64_t writeSeq;         // Next sequence number to write
+    uint64_t readSeq;          // Next sequence number the reader wants
+    uint64_t dropped;
+
+    // Sampler-only state.
+    uint64_t prevNs;
+    uint64_t prevCpuTicks;
+    uint64_t prevMinorFaults;
+    uint64_t prevMajorFaults;
+    uint64_t prevReadBytes;
+    uint64_t prevWriteBytes;
+    uint64_t mapsNs;
+    uint64_t heap, stack, anon, fileBacked;
+    unordered_map<int, ThreadCounters> prevThreads;
+};
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Counts entries in /proc/[pid]/fd without resolving them.
+static int countFds(int pidFd) {
+    int fd = openat(pidFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return 0;
+    }
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// Splits the address space into heap/stack/anonymous/file-backed totals.
+static void readMapsBreakdown(InspectorSession* s) {
+    string text;
+    if (!readFileAt(s->pidFd, "maps", text)) return;
+    uint64_t heap = 0, stack = 0, anon = 0, fileBacked = 0;
+    const char* p = text.c_str();
+    while (*p) {
+        const char* eol = strchr(p, '\n');
+        if (!eol) eol = p + strlen(p);
+        char* end = nullptr;
+        uint64_t start = strtoull(p, &end, 16);
+        uint64_t stop = strtoull(end + 1, &end, 16);
+        uint64_t sizeKB = (stop - start) / 1024;
+
+        // perms offset dev inode [path]
+        unsigned long long inode = 0;
+        const char* field = end;
+        for (int i = 0; i < 3 && field < eol; i++) {
+            field = strchr(field + 1, ' ');
+            if (!field || field > eol) break;
+        }
+        if (field && field < eol) inode = strtoull(field + 1, &end, 10);
+        const char* path = (field && field < eol) ? end : eol;
+        while (path < eol && *path == ' ') path++;
+
+        if (strncmp(path, "[heap]", 6) == 0) {
+            heap += sizeKB;
+        } else if (strncmp(path, "[stack", 6) == 0) {
+            stack += sizeKB;
+        } else if (inode != 0) {
+            fileBacked += sizeKB;
+        } else {
+            anon += sizeKB;
+        }
+        p = *eol ? eol + 1 : eol;
+    }
+    s->heap = heap;
+    s->stack = stack;
+    s->anon = anon;
+    s->fileBacked = fileBacked;
+}
+
+// Fills per-thread CPU and fault rates from /proc/[pid]/task/*/stat.
+static void sampleThreads(InspectorSession* s, InspectSample& sample, double elapsedSec) {
+    int fd = openat(s->pidFd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return;
+    }
+    const double ticksPerSec = (double)clockTicksPerSecond();
+    unordered_map<int, ThreadCounters> current;
+    string text;
+    char statPath[sizeof(((struct dirent*)0)->d_name) + 8];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        snprintf(statPath, sizeof(statPath), "%s/stat", entry->d_name);
+        ProcStat stat;
+        if (!readFileAt(dirfd(dir), statPath, text) || !parseProcStat(text, stat)) continue;
+
+        int tid = atoi(entry->d_name);
+        ThreadCounters counters{stat.utimeTicks + stat.stimeTicks, stat.minorFaults, stat.majorFaults};
+        current[tid] = counters;
+        sample.threadCount++;
+        if (sample.reportedThreads >= kMaxInspectThreads) continue;
+
+        ThreadSample& t = sample.threads[sample.reportedThreads++];
+        t.tid = tid;
+        strncpy(t.name, stat.comm.c_str(), sizeof(t.name) - 1);
+        t.name[sizeof(t.name) - 1] = '\0';
+        t.cpuUsage = t.minorFaultsPerSec = t.majorFaultsPerSec = 0.0;
+        auto prev = s->prevThreads.find(tid);
+        if (prev != s->prevThreads.end() && elapsedSec > 0) {
+            t.cpuUsage = (double)(counters.cpuTicks - prev->second.cpuTicks) / ticksPerSec / elapsedSec * 100.0;
+            t.minorFaultsPerSec = (double)(counters.minorFaults - prev->second.minorFaults) / elapsedSec;
+            t.majorFaultsPerSec = (double)(counters.majorFaults - prev->second.majorFaults) / elapsedSec;
+        }
+    }
+    closedir(dir);
+    s->prevThreads.swap(current);
+}
+
+// Takes one sample. Returns false once the process has gone away.
+static bool takeSample(InspectorSession* s) {
+    string text;
+    ProcStat stat;
+    if (!readFileAt(s->pidFd, "stat", text) || !parseProcStat(text, stat) || stat.state == 'Z') {
+        return false;
+    }
+    const uint64_t nowNs = monotonicNs();
+    const bool first = s->prevNs == 0;
+    const double elapsedSec = first ? 0.0 : (double)(nowNs - s->prevNs) / 1e9;
+
+    uint64_t readBytes, writeBytes;
+    readProcIo(s->pidFd, readBytes, writeBytes);
+    if (first || nowNs - s->mapsNs >= kMapsIntervalNs) {
+        readMapsBreakdown(s);
+        s->mapsNs = nowNs;
+    }
+    const uint64_t cpuTicks = stat.utimeTicks + stat.stimeTicks;
+
+    InspectSample& sample = s->scratch;
+    sample.timestampMs = nowNs / 1000000ULL;
+    sample.rss = stat.rssPages * pageSizeKB();
+    sample.fdCount = countFds(s->pidFd);
+    sample.heap = s->heap;
+    sample.stack = s->stack;
+    sample.anon = s->anon;
+    sample.fileBacked = s->fileBacked;
+    sample.cpuUsage = sample.minorFaultsPerSec = sample.majorFaultsPerSec = 0.0;
+    sample.readBytesPerSec = sample.writeBytesPerSec = 0.0;
+    if (!first && elapsedSec > 0) {
+        sample.cpuUsage = (double)(cpuTicks - s->prevCpuTicks) / (double)clockTicksPerSecond() / elapsedSec * 100.0;
+        sample.minorFaultsPerSec = (double)(stat.minorFaults - s->prevMinorFaults) / elapsedSec;
+        sample.majorFaultsPerSec = (double)(stat.majorFaults - s->prevMajorFaults) / elapsedSec;
+        sample.readBytesPerSec = (double)(readBytes - s->prevReadBytes) / elapsedSec;
+        sample.writeBytesPerSec = (double)(writeBytes - s->prevWriteBytes) / elapsedSec;
+    }
+    sample.threadCount = 0;
+    sample.reportedThreads = 0;
+    sampleThreads(s, sample, elapsedSec);
+
+    {
+        lock_guard<mutex> lock(s->ringMutex);
+        const size_t capacity = s->ring.size();
+        if (s->writeSeq - s->readSeq >= capacity) {
+            // Reader fell behind; overwrite the oldest sample.
+            s->readSeq++;
+            s->dropped++;
+        }
+        sample.seq = s->writeSeq;
+        memcpy(&s->ring[s->writeSeq % capacity], &sample, sizeof(InspectSample));
+        s->writeSeq++;
+    }
+
+    s->prevNs = nowNs;
+    s->prevCpuTicks = cpuTicks;
+    s->prevMinorFaults = stat.minorFaults;
+    s->prevMajorFaults = stat.majorFaults;
+    s->prevReadBytes = readBytes;
+    s->prevWriteBytes = writeBytes;
+    return true;
+}
+
+static void samplerLoop(InspectorSession* s) {
+    struct pollfd fds[2];
+    fds[0].fd = s->timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = s->stopFd;
+    fds[1].events = POLLIN;
+    while (true) {
+        if (poll(fds, 2, -1) < 0) continue;
+        if (fds[1].revents & POLLIN) break;
+        if (fds[0].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(s->timerFd, &expirations, sizeof(expirations)) < 0) continue;
+            if (!takeSample(s)) break;
+        }
+    }
+    s->alive = false;
+}
+
+void* startProcessInspector(int pid, int hz, int capacity) {
+    hz = max(1, min(hz, 100));
+    capacity = max(16, min(capacity, 65536));
+
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d", pid);
+    int pidFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pidFd < 0) return nullptr;
+
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    int stopFd = eventfd(0, EFD_CLOEXEC);
+    if (timerFd < 0 || stopFd < 0) {
+        if (timerFd >= 0) close(timerFd);
+        if (stopFd >= 0) close(stopFd);
+        close(pidFd);
+        return nullptr;
+    }
+    struct itimerspec spec{};
+    spec.it_interval.tv_sec = hz == 1 ? 1 : 0;
+    spec.it_interval.tv_nsec = hz == 1 ? 0 : 1000000000L / hz;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+
+    InspectorSession* s = new InspectorSession();
+    s->pid = pid;
+    s->pidFd = pidFd;
+    s->timerFd = timerFd;
+    s->stopFd = stopFd;
+    s->alive = true;
+    s->ring.resize((size_t)capacity);
+    s->writeSeq = s->readSeq = s->dropped = 0;
+    s->prevNs = s->prevCpuTicks = s->prevMinorFaults = s->prevMajorFaults = 0;
+    s->prevReadBytes = s->prevWriteBytes = s->mapsNs = 0;
+    s->heap = s->stack = s->anon = s->fileBacked = 0;
+    s->worker = thread(samplerLoop, s);
+    return s;
+}
+
+static string getProcessInspectorSamplesJSON_Internal(InspectorSession* s) {
+    ostringstream json;
+    lock_guard<mutex> lock(s->ringMutex);
+    json << "{ \"pid\": " << s->pid << ", ";
+    json << "\"alive\": " << (s->alive ? "true" : "false") << ", ";
+    json << "\"dropped\": " << s->dropped << ", ";
+    json << "\"samples\": [";
+    const size_t capacity = s->ring.size();
+    for (uint64_t seq = s->readSeq; seq < s->writeSeq; seq++) {
+        const InspectSample& p = s->ring[seq % capacity];
+        json << "{";
+        json << "\"timestampMs\": " << p.timestampMs << ", ";
+        json << "\"cpuUsage\": " << p.cpuUsage << ", ";
+        json << "\"rss\": " << p.rss << ", ";
+        json << "\"minorFaultsPerSec\": " << p.minorFaultsPerSec << ", ";
+        json << "\"majorFaultsPerSec\": " << p.majorFaultsPerSec << ", ";
+        json << "\"readBytesPerSec\": " << p.readBytesPerSec << ", ";
+        json << "\"writeBytesPerSec\": " << p.writeBytesPerSec << ", ";
+        json << "\"fdCount\": " << p.fdCount << ", ";
+        json << "\"heap\": " << p.heap << ", ";
+        json << "\"stack\": " << p.stack << ", ";
+        json << "\"anon\": " << p.anon << ", ";
+        json << "\"fileBacked\": " << p.fileBacked << ", ";
+        json << "\"threadCount\": " << p.threadCount << ", ";
+        json << "\"threads\": [";
+        for (int i = 0; i < p.reportedThreads; i++) {
+            const ThreadSample& t = p.threads[i];
+            json << "{\"tid\": " << t.tid << ", ";
+            json << "\"name\": \"" << jsonEscape(t.name) << "\", ";
+            json << "\"cpuUsage\": " << t.cpuUsage << ", ";
+            json << "\"minorFaultsPerSec\": " << t.minorFaultsPerSec << ", ";
+            json << "\"majorFaultsPerSec\": " << t.majorFaultsPerSec << "}";
+            if (i < p.reportedThreads - 1)
+                json << ", ";
+        }
+        json << "]}";
+        if (seq + 1 < s->writeSeq)
+            json << ", ";
+    }
+    json << "] }";
+    s->readSeq = s->writeSeq;
+    return json.str();
+}
+
+char* getProcessInspectorSamplesJSON(void* session) {
+    if (!session) {
+        return strdup_cstr("{ \"samples\": 0 }");
+    }
+    return strdup_cstr(getProcessInspectorSamplesJSON_Internal((InspectorSession*)session));
+}
+
+void releaseProcessInspector(void* session) {
+    if (!session) return;
+    InspectorSession* s = (InspectorSession*)session;
+    uint64_t one = 1;
+    ssize_t written = write(s->stopFd, &one, sizeof(one));
+    (void)written;
+    if (s->worker.joinable()) {
+        s->worker.join();
+    }
+    close(s->timerFd);
+    close(s->stopFd);
+    close(s->pidFd);
+    delete s;
+}
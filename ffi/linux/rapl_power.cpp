@@ -0,0 +1,184 @@
+#include "include/rapl_power.h"
+#include "include/proc_reader.h"
+#include "include/sampler.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct RaplZone {
+    RaplDomain domain;
+    string energyPath;
+    uint64_t maxRange = 0;   // µJ at which energy_uj wraps to 0
+    uint64_t lastEnergy = 0;
+    bool primed = false;
+    double joulesAtTick = 0.0;   // Total at the last sampler tick, for watts
+    uint64_t tickNs = 0;
+};
+
+static mutex raplMutex;
+static string sysfsRoot = "/sys";
+static vector<RaplZone> zones;
+static bool zonesEnumerated = false;
+
+static bool readUnsigned(const string& path, uint64_t& value) {
+    string text;
+    if (!readFile(path.c_str(), text) || text.empty() || text[0] < '0' || text[0] > '9') return false;
+    value = strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+// Caller holds raplMutex.
+static void enumerateZones() {
+    zones.clear();
+    string powercap = sysfsRoot + "/class/powercap";
+    DIR* dir = opendir(powercap.c_str());
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            // intel-rapl:N[:M] and intel-rapl-mmio:N; the bare "intel-rapl"
+            // control type directory has no counter.
+            const char* name = entry->d_name;
+            if (strncmp(name, "intel-rapl", 10) != 0 || !strchr(name, ':')) continue;
+            string base = powercap + "/" + name;
+            RaplZone z;
+            z.domain.zone = name;
+            readFile((base + "/name").c_str(), z.domain.name);
+            z.domain.name = z.domain.name.substr(0, z.domain.name.find('\n'));
+            z.domain.package = strchr(name, ':') == strrchr(name, ':');
+            z.domain.watts = z.domain.joules = 0.0;
+            z.energyPath = base + "/energy_uj";
+            z.domain.readable = access(z.energyPath.c_str(), R_OK) == 0;
+            if (!readUnsigned(base + "/max_energy_range_uj", z.maxRange)) z.maxRange = 0;
+            zones.push_back(z);
+        }
+        closedir(dir);
+    }
+    sort(zones.begin(), zones.end(),
+         [](const RaplZone& a, const RaplZone& b) { return a.domain.zone < b.domain.zone; });
+    zonesEnumerated = true;
+}
+
+// Folds a fresh energy_uj reading into the zone's joule total. Caller holds
+// raplMutex.
+static void accumulateZone(RaplZone& z) {
+    uint64_t energy;
+    if (!z.domain.readable || !readUnsigned(z.energyPath, energy)) return;
+    if (z.primed) {
+        // A drop is a wrap only if the range is known and explains it;
+        // otherwise (counter reset, bogus range) re-prime from here.
+        bool wrapped = energy < z.lastEnergy;
+        bool valid = !wrapped || (z.maxRange > 0 && z.lastEnergy <= z.maxRange);
+        uint64_t delta = !valid ? 0 : wrapped ? z.maxRange - z.lastEnergy + energy : energy - z.lastEnergy;
+        if (valid && (z.maxRange == 0 || delta <= z.maxRange)) z.domain.joules += delta / 1e6;
+    }
+    z.lastEnergy = energy;
+    z.primed = true;
+}
+
+static void sampleRapl(uint64_t nowNs) {
+    lock_guard<mutex> lock(raplMutex);
+    if (!zonesEnumerated) enumerateZones();
+    for (RaplZone& z : zones) {
+        accumulateZone(z);
+        if (z.tickNs && nowNs > z.tickNs) {
+            z.domain.watts = (z.domain.joules - z.joulesAtTick) / ((nowNs - z.tickNs) / 1e9);
+        }
+        z.joulesAtTick = z.domain.joules;
+        z.tickNs = nowNs;
+    }
+}
+
+static void ensureRaplSampler() {
+    registerSampler("rapl", sampleRapl);
+}
+
+vector<RaplDomain> raplDomains() {
+    ensureRaplSampler();
+    lock_guard<mutex> lock(raplMutex);
+    vector<RaplDomain> domains;
+    for (const RaplZone& z : zones) domains.push_back(z.domain);
+    return domains;
+}
+
+// The package-N zones. psys covers the whole SoC and would double count
+// them; intel-rapl-mmio duplicates the MSR package counter.
+static bool isPackageZone(const RaplZone& z) {
+    return z.domain.package && z.domain.readable && z.domain.name.compare(0, 8, "package-") == 0 &&
+           z.domain.zone.compare(0, 15, "intel-rapl-mmio") != 0;
+}
+
+bool raplPackageWatts(double& watts) {
+    ensureRaplSampler();
+    lock_guard<mutex> lock(raplMutex);
+    watts = 0.0;
+    bool found = false;
+    for (const RaplZone& z : zones) {
+        if (!isPackageZone(z)) continue;
+        watts += z.domain.watts;
+        found = true;
+    }
+    return found;
+}
+
+bool raplPackageJoules(double& joules) {
+    ensureRaplSampler();
+    lock_guard<mutex> lock(raplMutex);
+    if (!zonesEnumerated) enumerateZones();
+    joules = 0.0;
+    bool found = false;
+    for (RaplZone& z : zones) {
+        if (!isPackageZone(z)) continue;
+        accumulateZone(z); // Exact at the caller's time, not the last tick
+        joules += z.domain.joules;
+        found = true;
+    }
+    return found;
+}
+
+void setPowercapRoot(const char* root) {
+    lock_guard<mutex> lock(raplMutex);
+    sysfsRoot = root && *root ? root : "/sys";
+    zonesEnumerated = false;
+    zones.clear();
+}
+
+static string getRaplPowerJSON_Internal() {
+    vector<RaplDomain> domains = raplDomains();
+    double packageWatts = 0.0;
+    bool available = raplPackageWatts(packageWatts);
+    bool denied = false;
+    for (const RaplDomain& d : domains) denied = denied || !d.readable;
+
+    ostringstream json;
+    json << "{ \"available\": " << (available ? "true" : "false") << ", ";
+    // Since Linux 5.10 energy_uj is root-only; the UI can explain why.
+    json << "\"permissionDenied\": " << (denied ? "true" : "false") << ", ";
+    json << "\"packageWatts\": " << packageWatts << ", ";
+    json << "\"domains\": [";
+    for (size_t i = 0; i < domains.size(); i++) {
+        const RaplDomain& d = domains[i];
+        json << "{\"zone\": \"" << jsonEscape(d.zone) << "\", ";
+        json << "\"name\": \"" << jsonEscape(d.name) << "\", ";
+        json << "\"package\": " << (d.package ? "true" : "false") << ", ";
+        json << "\"readable\": " << (d.readable ? "true" : "false") << ", ";
+        json << "\"watts\": " << d.watts << ", ";
+        json << "\"joules\": " << d.joules << "}";
+        if (i < domains.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+char* getRaplPowerJSON() {
+    return strdup_cstr(getRaplPowerJSON_Internal());
+}
@@ -0,0 +1,492 @@
+#include "include/running_app_info.h"
+#include "include/drm_fdinfo.h"
+#include "include/open_files.h"
+#include "include/proc_reader.h"
+#include "include/rapl_power.h"
+#include "include/strdup_cstr.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Previous counters per pid, used to compute rates between sweeps.
+struct ProcessCounters {
+    uint64_t startTicks;
+    uint64_t cpuTicks;
+    uint64_t readBytes;
+    uint64_t writeBytes;
+    uint64_t contextSwitches;
+};
+
+// Cached smaps_rollup reading for one process.
+struct DeepMemoryEntry {
+    uint64_t startTicks;
+    DeepMemoryInfo info;
+    bool sampled;
+    Clock::time_point sampledAt;
+    Clock::time_point lastAttempt;
+};
+
+// Deep memory mode settings. smaps_rollup walks every VMA of the process
+// under mmap_lock, so it runs on its own slower cadence with a time budget.
+struct DeepMemoryConfig {
+    bool enabled = false;
+    int refreshIntervalMs = 10000;
+    int sweepBudgetMs = 25;
+};
+
+// DRM fds of a process. Finding them means a readlink per descriptor, so
+// the list is refreshed on a slow cadence; the fdinfo of the known DRM fds
+// is read on every sweep.
+struct DrmFdCache {
+    uint64_t startTicks;
+    vector<int> fds;
+    Clock::time_point scannedAt;
+};
+
+// Previous counters of one DRM client (keyed by pdev + client id).
+struct DrmClientSample {
+    DrmClientUsage usage;
+    Clock::time_point sampledAt;
+};
+
+// Listing every fd of every process each sweep is costly, so the DRM fds of a
+// process are rescanned this often. A DRM fd opened in between is missed (its
+// GPU usage reads 0) until the next rescan, i.e. for up to this long.
+static const auto kDrmFdRescanInterval = chrono::seconds(5);
+
+// Sweeps requested sooner than this after the previous one (e.g. the process
+// list and the application groups refreshing together) reuse its results, so
+// rates are never computed over a few milliseconds.
+static const auto kMinSweepInterval = chrono::milliseconds(500);
+
+// Energy impact weights, in "percent of one core" equivalents: a wakeup
+// pulls the core out of a deep C-state, disk and GPU work draw power of
+// their own outside the CPU time.
+static const double kEnergyPerWakeup = 0.02;       // 50 wakeups/s ~ 1% CPU
+static const double kEnergyPerDiskMBps = 0.5;
+static const double kEnergyPerGpuPercent = 1.0;
+
+static mutex sweepMutex;
+static unordered_map<int, ProcessCounters> previousCounters;
+static Clock::time_point previousSweep;
+static vector<ProgramInfo> previousPrograms;
+static unordered_map<int, DeepMemoryEntry> deepMemoryCache;
+static DeepMemoryConfig deepMemoryConfig;
+static unordered_map<int, DrmFdCache> drmFdCache;
+static unordered_map<string, DrmClientSample> drmClientSamples;
+static double previousPackageJoules = -1.0;
+
+//
+// Helper: Convert a start time (clock ticks after boot) to an ISO8601 string.
+//
+static string convertStartTicksToISO(uint64_t startTicks) {
+    time_t t = (time_t)(bootTimeSeconds() + startTicks / clockTicksPerSecond());
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    return string(buf);
+}
+
+//
+// Helper: Resolve a uid to a user name, caching the lookups.
+//
+static string userNameForUid(uid_t uid) {
+    static unordered_map<uid_t, string> cache;
+    auto it = cache.find(uid);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    struct passwd pw;
+    struct passwd* result = nullptr;
+    char buf[1024];
+    string name = to_string(uid);
+    if (getpwuid_r(uid, &pw, buf, sizeof(buf), &result) == 0 && result) {
+        name = result->pw_name;
+    }
+    cache[uid] = name;
+    return name;
+}
+
+//
+// Reads /proc/[pid]/smaps_rollup. Returns false if it is missing or denied.
+//
+static bool readSmapsRollup(int pid, DeepMemoryInfo& info) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    string text;
+    if (!readFile(path, text) || text.empty()) {
+        return false;
+    }
+    info.pss = findKbField(text, "Pss");
+    info.uss = findKbField(text, "Private_Clean") + findKbField(text, "Private_Dirty");
+    info.swap = findKbField(text, "Swap");
+    info.swapPss = findKbField(text, "SwapPss");
+    return true;
+}
+
+//
+// Refreshes the stalest deep memory entries until the sweep budget is spent,
+// then copies the cached values (tagged with their age) into `programs`.
+//
+static void refreshDeepMemory(vector<ProgramInfo>& programs, Clock::time_point now) {
+    const auto interval = chrono::milliseconds(deepMemoryConfig.refreshIntervalMs);
+
+    // Drop entries for exited processes and reused pids.
+    unordered_map<int, DeepMemoryEntry> live;
+    live.reserve(programs.size());
+    vector<pair<Clock::time_point, size_t>> due;
+    for (size_t i = 0; i < programs.size(); i++) {
+        const ProgramInfo& p = programs[i];
+        DeepMemoryEntry entry{};
+        auto it = deepMemoryCache.find(p.pid);
+        if (it != deepMemoryCache.end() && it->second.startTicks == p.startTicks) {
+            entry = it->second;
+        } else {
+            entry.startTicks = p.startTicks;
+            entry.sampled = false;
+        }
+        if (!entry.sampled) {
+            // Never sampled: schedule ahead of everything else.
+            if (entry.lastAttempt == Clock::time_point() || now - entry.lastAttempt >= interval) {
+                due.push_back({Clock::time_point(), i});
+            }
+        } else if (now - entry.lastAttempt >= interval) {
+            due.push_back({entry.sampledAt, i});
+        }
+        live[p.pid] = entry;
+    }
+    deepMemoryCache.swap(live);
+
+    sort(due.begin(), due.end(), [](const pair<Clock::time_point, size_t>& a,
+                                    const pair<Clock::time_point, size_t>& b) {
+        return a.first < b.first;
+    });
+
+    // The budget covers smaps_rollup reads only, not the /proc sweep before it.
+    const auto deadline = Clock::now() + chrono::milliseconds(deepMemoryConfig.sweepBudgetMs);
+    for (const auto& item : due) {
+        if (Clock::now() >= deadline) break;
+        const ProgramInfo& p = programs[item.second];
+        DeepMemoryEntry& entry = deepMemoryCache[p.pid];
+        DeepMemoryInfo info{};
+        entry.lastAttempt = Clock::now();
+        if (readSmapsRollup(p.pid, info)) {
+            entry.info = info;
+            entry.sampled = true;
+            entry.sampledAt = entry.lastAttempt;
+        }
+    }
+
+    const auto stamp = Clock::now();
+    for (ProgramInfo& p : programs) {
+        const DeepMemoryEntry& entry = deepMemoryCache[p.pid];
+        if (entry.sampled) {
+            p.deepMemory = entry.info;
+            p.deepMemory.ageMs = chrono::duration_cast<chrono::milliseconds>(stamp - entry.sampledAt).count();
+        }
+    }
+}
+
+// Per-engine busy percentage of one client since its previous sample.
+static void addClientBusy(const DrmClientUsage& usage, const DrmClientSample* prev, Clock::time_point now,
+                          map<string, double>& busyByEngine) {
+    if (!prev) return;
+    const double wallNs = (double)chrono::duration_cast<chrono::nanoseconds>(now - prev->sampledAt).count();
+    if (wallNs <= 0) return;
+    for (const auto& e : usage.engineNs) {
+        auto p = prev->usage.engineNs.find(e.first);
+        if (p != prev->usage.engineNs.end() && e.second >= p->second) {
+            busyByEngine[e.first] += (double)(e.second - p->second) / wallNs * 100.0;
+        }
+    }
+    // Drivers such as xe count GPU cycles instead of nanoseconds.
+    for (const auto& c : usage.cycles) {
+        auto total = usage.totalCycles.find(c.first);
+        auto pc = prev->usage.cycles.find(c.first);
+        auto pt = prev->usage.totalCycles.find(c.first);
+        if (total == usage.totalCycles.end() || pc == prev->usage.cycles.end() ||
+            pt == prev->usage.totalCycles.end() || total->second <= pt->second || c.second < pc->second) {
+            continue;
+        }
+        busyByEngine[c.first] += (double)(c.second - pc->second) / (double)(total->second - pt->second) * 100.0;
+    }
+}
+
+//
+// GPU usage of one process from the fdinfo of its DRM fds. A client shared
+// by several fds or processes is counted once, for the first pid seen.
+//
+static void collectDrmUsage(int pidFd, ProgramInfo& info, Clock::time_point now,
+                            unordered_map<int, DrmFdCache>& liveFds, unordered_set<string>& seenClients,
+                            unordered_map<string, DrmClientSample>& clientSamples, vector<OpenFdEntry>& fdScratch) {
+    auto cached = drmFdCache.find(info.pid);
+    DrmFdCache entry;
+    if (cached != drmFdCache.end() && cached->second.startTicks == info.startTicks &&
+        now - cached->second.scannedAt < kDrmFdRescanInterval) {
+        entry = std::move(cached->second);
+    } else {
+        entry.startTicks = info.startTicks;
+        entry.scannedAt = now;
+        if (listProcessFds(pidFd, fdScratch)) {
+            for (const OpenFdEntry& fd : fdScratch) {
+                if (fd.target.compare(0, 9, "/dev/dri/") == 0) entry.fds.push_back(fd.fd);
+            }
+        }
+    }
+
+    map<string, double> busyByEngine;
+    string text;
+    char name[32];
+    for (int fd : entry.fds) {
+        snprintf(name, sizeof(name), "fdinfo/%d", fd);
+        DrmClientUsage usage;
+        if (!readFileAt(pidFd, name, text) || !parseDrmFdinfo(text, usage)) continue;
+        string key = usage.pdev + "/" + to_string(usage.clientId);
+        if (!seenClients.insert(key).second) continue;
+        auto prev = drmClientSamples.find(key);
+        addClientBusy(usage, prev != drmClientSamples.end() ? &prev->second : nullptr, now, busyByEngine);
+        info.gpuMemory += usage.memoryKB;
+        clientSamples[key] = DrmClientSample{std::move(usage), now};
+    }
+    for (const auto& e : busyByEngine) info.gpuUsage = max(info.gpuUsage, min(100.0, e.second));
+    liveFds[info.pid] = std::move(entry); // Also remembers "no DRM fds" until the next rescan
+}
+
+//
+// Scores every process and, when RAPL is readable, splits the package energy
+// measured over the sweep interval in proportion to the scores.
+//
+static void assignEnergyImpact(vector<ProgramInfo>& programs, double elapsedSec) {
+    double totalScore = 0.0;
+    for (ProgramInfo& p : programs) {
+        double diskMBps = (p.readBytesPerSec + p.writeBytesPerSec) / (1024.0 * 1024.0);
+        p.energyImpact = p.cpuUsage + kEnergyPerWakeup * p.wakeupsPerSec +
+                         kEnergyPerDiskMBps * diskMBps + kEnergyPerGpuPercent * p.gpuUsage;
+        p.energyWatts = -1.0;
+        totalScore += p.energyImpact;
+    }
+
+    double joules;
+    if (!raplPackageJoules(joules)) {
+        previousPackageJoules = -1.0;
+        return;
+    }
+    double previous = previousPackageJoules;
+    previousPackageJoules = joules;
+    if (previous < 0 || elapsedSec <= 0 || joules < previous) return;
+    double packageWatts = (joules - previous) / elapsedSec;
+    for (ProgramInfo& p : programs) {
+        p.energyWatts = totalScore > 0 ? packageWatts * p.energyImpact / totalScore : 0.0;
+    }
+}
+
+//
+// Retrieves detailed information about running processes from /proc.
+// For any field that requires extra permission, if access is denied the code assigns 0 (or "0").
+//
+vector<ProgramInfo> collectRunningPrograms() {
+    lock_guard<mutex> lock(sweepMutex);
+    const Clock::time_point now = Clock::now();
+    if (previousSweep != Clock::time_point() && now - previousSweep < kMinSweepInterval) {
+        return previousPrograms;
+    }
+
+    vector<ProgramInfo> programs;
+    int procFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) {
+        return programs;
+    }
+    DIR* dir = fdopendir(procFd);
+    if (!dir) {
+        close(procFd);
+        return programs;
+    }
+
+    const double elapsedSec = previousSweep == Clock::time_point()
+        ? 0.0 : chrono::duration<double>(now - previousSweep).count();
+    const double ticksPerSec = (double)clockTicksPerSecond();
+    const double uptimeTicks = (double)(time(nullptr) - (time_t)bootTimeSeconds()) * ticksPerSec;
+
+    unordered_map<int, ProcessCounters> currentCounters;
+    unordered_map<int, DrmFdCache> liveDrmFds;
+    unordered_map<string, DrmClientSample> currentClientSamples;
+    unordered_set<string> seenDrmClients;
+    vector<OpenFdEntry> fdScratch;
+    string text;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        int pidFd = openat(procFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidFd < 0) continue;
+
+        ProcStat stat;
+        if (!readFileAt(pidFd, "stat", text) || !parseProcStat(text, stat)) {
+            close(pidFd);
+            continue; // Process exited mid-sweep
+        }
+
+        ProgramInfo info;
+        info.pid = atoi(entry->d_name);
+        info.parentPid = stat.ppid;
+        info.name = stat.comm;
+        info.memoryUsage = (int)(stat.rssPages * pageSizeKB());
+        info.threadCount = stat.numThreads;
+        info.state = string(1, stat.state);
+        info.windowTitle = "0";
+        info.startTicks = stat.startTicks;
+        info.cpuTicks = stat.utimeTicks + stat.stimeTicks;
+        info.startTime = convertStartTicksToISO(stat.startTicks);
+        info.deepMemory = DeepMemoryInfo{0, 0, 0, 0, -1};
+        info.gpuUsage = 0.0;
+        info.gpuMemory = 0;
+        info.contextSwitches = 0;
+        info.wakeupsPerSec = 0.0;
+
+        readProcIo(pidFd, info.readBytes, info.writeBytes);
+        if (readFileAt(pidFd, "status", text)) {
+            info.contextSwitches = findKbField(text, "voluntary_ctxt_switches") +
+                                   findKbField(text, "nonvoluntary_ctxt_switches");
+        }
+
+        // Rates since the previous sweep; lifetime average CPU for new pids.
+        info.readBytesPerSec = info.writeBytesPerSec = 0.0;
+        auto prev = previousCounters.find(info.pid);
+        if (prev != previousCounters.end() && prev->second.startTicks == info.startTicks && elapsedSec > 0) {
+            info.cpuUsage = (double)(info.cpuTicks - prev->second.cpuTicks) / ticksPerSec / elapsedSec * 100.0;
+            if (info.readBytes >= prev->second.readBytes && info.writeBytes >= prev->second.writeBytes) {
+                info.readBytesPerSec = (double)(info.readBytes - prev->second.readBytes) / elapsedSec;
+                info.writeBytesPerSec = (double)(info.writeBytes - prev->second.writeBytes) / elapsedSec;
+            }
+            if (info.contextSwitches >= prev->second.contextSwitches) {
+                info.wakeupsPerSec = (double)(info.contextSwitches - prev->second.contextSwitches) / elapsedSec;
+            }
+        } else {
+            double lifetime = uptimeTicks - (double)info.startTicks;
+            info.cpuUsage = lifetime > 0 ? (double)info.cpuTicks / lifetime * 100.0 : 0.0;
+        }
+        currentCounters[info.pid] = ProcessCounters{info.startTicks, info.cpuTicks, info.readBytes,
+                                                      info.writeBytes, info.contextSwitches};
+
+        // The owner of /proc/[pid] is the real uid of the process.
+        struct stat st;
+        info.user = fstat(pidFd, &st) == 0 ? userNameForUid(st.st_uid) : "0";
+
+        // Retrieve the full executable path. If permission is lacking, set to "0".
+        char pathBuffer[4096];
+        ssize_t len = readlinkat(pidFd, "exe", pathBuffer, sizeof(pathBuffer) - 1);
+        if (len > 0) {
+            pathBuffer[len] = '\0';
+            info.executablePath = pathBuffer;
+            size_t pos = info.executablePath.find_last_of('/');
+            if (pos != string::npos && pos + 1 < info.executablePath.size()) {
+                info.name = info.executablePath.substr(pos + 1);
+            }
+        } else {
+            info.executablePath = "0";
+        }
+
+        collectDrmUsage(pidFd, info, now, liveDrmFds, seenDrmClients, currentClientSamples, fdScratch);
+
+        close(pidFd);
+        programs.push_back(info);
+    }
+    closedir(dir);
+
+    previousCounters.swap(currentCounters);
+    previousSweep = now;
+    drmFdCache.swap(liveDrmFds);
+    drmClientSamples.swap(currentClientSamples);
+    assignEnergyImpact(programs, elapsedSec);
+
+    if (deepMemoryConfig.enabled) {
+        refreshDeepMemory(programs, now);
+    } else {
+        deepMemoryCache.clear();
+    }
+    previousPrograms = programs;
+    return programs;
+}
+
+void setDeepMemoryMode(int enabled, int refreshIntervalMs, int sweepBudgetMs) {
+    lock_guard<mutex> lock(sweepMutex);
+    deepMemoryConfig.enabled = enabled != 0;
+    if (refreshIntervalMs > 0) deepMemoryConfig.refreshIntervalMs = refreshIntervalMs;
+    if (sweepBudgetMs > 0) deepMemoryConfig.sweepBudgetMs = sweepBudgetMs;
+}
+
+static string getRunningProcessesJSON_Internal() {
+    vector<ProgramInfo> programs = collectRunningPrograms();
+    if (programs.empty()) {
+        return "{ \"running_programs\": 0 }";
+    }
+    bool deepMemory;
+    {
+        lock_guard<mutex> lock(sweepMutex);
+        deepMemory = deepMemoryConfig.enabled;
+    }
+
+    // Build JSON output.
+    ostringstream json;
+    json << "{ \"running_programs\": [";
+    for (size_t i = 0; i < programs.size(); i++) {
+        const ProgramInfo &p = programs[i];
+        json << "{";
+        json << "\"pid\": " << p.pid << ", ";
+        json << "\"parentPid\": " << p.parentPid << ", ";
+        json << "\"name\": \"" << jsonEscape(p.name) << "\", ";
+        json << "\"cpuUsage\": " << p.cpuUsage << ", ";
+        json << "\"memoryUsage\": " << p.memoryUsage << ", ";
+        if (deepMemory) {
+            json << "\"pss\": " << p.deepMemory.pss << ", ";
+            json << "\"uss\": " << p.deepMemory.uss << ", ";
+            json << "\"swap\": " << p.deepMemory.swap << ", ";
+            json << "\"swapPss\": " << p.deepMemory.swapPss << ", ";
+            json << "\"memoryAgeMs\": " << p.deepMemory.ageMs << ", ";
+        }
+        json << "\"executablePath\": \"" << jsonEscape(p.executablePath) << "\", ";
+        json << "\"startTime\": \"" << p.startTime << "\", ";
+        json << "\"threadCount\": " << p.threadCount << ", ";
+        json << "\"user\": \"" << jsonEscape(p.user) << "\", ";
+        json << "\"state\": \"" << p.state << "\", ";
+        json << "\"gpuUsage\": " << p.gpuUsage << ", ";
+        json << "\"gpuMemory\": " << p.gpuMemory << ", ";
+        json << "\"wakeupsPerSec\": " << p.wakeupsPerSec << ", ";
+        json << "\"energyImpact\": " << p.energyImpact << ", ";
+        json << "\"energyWatts\": " << p.energyWatts << ", ";
+        json << "\"windowTitle\": \"" << p.windowTitle << "\"";
+        json << "}";
+        if (i < programs.size() - 1)
+            json << ", ";
+    }
+    json << "] }";
+    return json.str();
+}
+
+//
+// Exposed functions for FFI.
+//
+// The caller on the Flutter side is responsible for freeing the returned memory.
+//
+
+char* getRunningProcessesJSON() {
+    return strdup_cstr(getRunningProcessesJSON_Internal());
+}
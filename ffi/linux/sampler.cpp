@@ -0,0 +1,74 @@
+#include "include/sampler.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <time.h>
+
+using namespace std;
+
+static mutex samplerMutex;
+static condition_variable samplerWake;
+static map<string, function<void(uint64_t)>> samplers;
+static int intervalMs = 1000;
+static bool threadStarted = false;
+
+uint64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void samplerLoop() {
+    unique_lock<mutex> lock(samplerMutex);
+    auto last = chrono::steady_clock::now();
+    while (true) {
+        auto next = last + chrono::milliseconds(intervalMs);
+        auto now = chrono::steady_clock::now();
+        if (now < next) {
+            // Also woken by setSamplingInterval(); loop to recompute `next`.
+            samplerWake.wait_until(lock, next);
+            continue;
+        }
+        // Stay phase-locked, but re-anchor after a long stall (suspend)
+        // instead of firing a burst of catch-up ticks.
+        last = now - next > chrono::milliseconds(intervalMs) ? now : next;
+
+        // Collectors run without the lock so they can be registered concurrently.
+        auto current = samplers;
+        lock.unlock();
+        uint64_t nowNs = monotonicNanos();
+        for (auto& entry : current) {
+            entry.second(nowNs);
+        }
+        lock.lock();
+    }
+}
+
+void registerSampler(const char* name, function<void(uint64_t)> tick) {
+    {
+        lock_guard<mutex> lock(samplerMutex);
+        if (samplers.count(name)) return;
+        samplers[name] = tick;
+        if (!threadStarted) {
+            threadStarted = true;
+            // Lives for the lifetime of the process, like the library.
+            thread(samplerLoop).detach();
+        }
+    }
+    tick(monotonicNanos()); // Baseline so the first interval already has deltas
+}
+
+void setSamplingInterval(int ms) {
+    lock_guard<mutex> lock(samplerMutex);
+    intervalMs = max(50, min(ms, 60000));
+    samplerWake.notify_all();
+}
+
+int samplingIntervalMs() {
+    lock_guard<mutex> lock(samplerMutex);
+    return intervalMs;
+}
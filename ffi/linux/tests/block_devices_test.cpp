@@ -0,0 +1,51 @@
+// Matches block devices to the mounts of fixtures/mountinfo/btrfs_host.txt:
+// btrfs subvolumes on an anonymous 0:31 device are found through their
+// source, stacked devices through their holders.
+#include "../include/block_devices.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixtures/mountinfo>\n", argv[0]);
+        return 2;
+    }
+    ifstream in(string(argv[1]) + "/btrfs_host.txt");
+    CHECK(in.good());
+    ostringstream text;
+    text << in.rdbuf();
+    vector<MountEntry> mounts = parseMountInfo(text.str());
+    map<string, string> devByName = {{"nvme0n1p1", "259:1"}, {"nvme0n1p2", "259:2"}, {"dm-0", "253:0"}};
+
+    // 259:2 never appears in mountinfo; both subvolumes match by source.
+    vector<string> btrfs = deviceMountPoints("nvme0n1p2", "259:2", {}, devByName, mounts);
+    CHECK((btrfs == vector<string>{"/", "/home"}));
+
+    CHECK((deviceMountPoints("nvme0n1p1", "259:1", {}, devByName, mounts) == vector<string>{"/boot/efi"}));
+
+    // An LVM volume on sda1 is mounted as /dev/mapper/vg-data on 253:0.
+    CHECK((deviceMountPoints("sda1", "8:1", {"dm-0"}, devByName, mounts) == vector<string>{"/mnt/My Disk"}));
+
+    CHECK(deviceMountPoints("sdb", "8:16", {}, devByName, mounts).empty());
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("block_devices_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Parses the fdinfo texts in fixtures/drm_fdinfo, laid out the way amdgpu
+// (with and without drm-resident-*), i915 and xe print them. xe.txt has no
+// trailing newline on purpose.
+#include "../include/drm_fdinfo.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+static string fixtureDir;
+
+static bool parseFixture(const char* name, DrmClientUsage& usage) {
+    ifstream in(fixtureDir + "/" + name);
+    CHECK(in.good());
+    ostringstream text;
+    text << in.rdbuf();
+    return parseDrmFdinfo(text.str(), usage);
+}
+
+static uint64_t value(const map<string, uint64_t>& m, const string& key) {
+    auto it = m.find(key);
+    return it != m.end() ? it->second : ~0ULL;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixtures/drm_fdinfo>\n", argv[0]);
+        return 2;
+    }
+    fixtureDir = argv[1];
+    DrmClientUsage u;
+
+    // Engine time in ns; drm-resident-* wins over drm-memory-*, and
+    // drm-total-*/shared/amd-* lines are ignored.
+    CHECK(parseFixture("amdgpu.txt", u));
+    CHECK(u.driver == "amdgpu");
+    CHECK(u.pdev == "0000:03:00.0");
+    CHECK(u.clientId == 42);
+    CHECK(u.engineNs.size() == 4);
+    CHECK(value(u.engineNs, "gfx") == 1234567890ULL);
+    CHECK(value(u.engineNs, "dec") == 5000);
+    CHECK(value(u.engineNs, "compute") == 0);
+    CHECK(u.cycles.empty() && u.totalCycles.empty());
+    CHECK(u.memoryKB == 131072 + 4096);
+
+    // Only drm-memory-*: summed over regions, MiB converted.
+    CHECK(parseFixture("amdgpu_legacy.txt", u));
+    CHECK(u.clientId == 17);
+    CHECK(value(u.engineNs, "gfx") == 987654);
+    CHECK(u.memoryKB == 65536 + 2 * 1024);
+
+    // Capacity lines are not engines; GiB and plain byte values convert.
+    CHECK(parseFixture("i915.txt", u));
+    CHECK(u.driver == "i915");
+    CHECK(u.clientId == 7);
+    CHECK(u.engineNs.size() == 4);
+    CHECK(value(u.engineNs, "render") == 25662044495ULL);
+    CHECK(value(u.engineNs, "video") == 7);
+    CHECK(value(u.engineNs, "video-enhance") == 0);
+    CHECK(u.engineNs.count("capacity-video") == 0);
+    CHECK(u.memoryKB == 1024 * 1024 + 8192 / 1024);
+
+    // Cycles and total cycles per engine, no ns counters.
+    CHECK(parseFixture("xe.txt", u));
+    CHECK(u.driver == "xe");
+    CHECK(u.pdev == "0000:00:02.0");
+    CHECK(u.clientId == 52);
+    CHECK(u.engineNs.empty());
+    CHECK(u.cycles.size() == 5 && u.totalCycles.size() == 5);
+    CHECK(value(u.cycles, "rcs") == 28257900);
+    CHECK(value(u.totalCycles, "rcs") == 7655183225ULL);
+    CHECK(value(u.totalCycles, "ccs") == 7655183225ULL);
+    CHECK(u.memoryKB == 192 + 2 * 1024);
+
+    // A regular file's fdinfo has no drm-client-id.
+    CHECK(!parseFixture("not_drm.txt", u));
+    CHECK(!parseDrmFdinfo("", u));
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("drm_fdinfo_test: ok\n");
+    return 0;
+}
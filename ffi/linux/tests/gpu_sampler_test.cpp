@@ -0,0 +1,121 @@
+// Drives the GPU sampler against the fake sysfs tree in fixtures/gpu_sysfs:
+// an amdgpu card (card0), an i915 card with two GTs (card1) and an xe card
+// (card2). The tree is copied first because the test bumps idle counters.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+extern "C" {
+char* gpuSamples(int maxSamples);
+double gpuUsages();
+void gpuSysfsRoot(const char* root);
+void samplingInterval(int intervalMs);
+void free_cstr(char* ptr);
+}
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+static string samples(int maxSamples) {
+    char* json = gpuSamples(maxSamples);
+    string text = json ? json : "";
+    free_cstr(json);
+    return text;
+}
+
+// The JSON object of one card, up to the next card.
+static string cardBlock(const string& json, const string& card) {
+    size_t start = json.find("{\"card\": \"" + card + "\"");
+    if (start == string::npos) return "";
+    size_t end = json.find("{\"card\": ", start + 1);
+    return json.substr(start, end == string::npos ? string::npos : end - start);
+}
+
+static bool contains(const string& text, const string& needle) {
+    return text.find(needle) != string::npos;
+}
+
+static void addToCounter(const fs::path& path, uint64_t delta) {
+    uint64_t value = 0;
+    ifstream(path) >> value;
+    ofstream(path) << value + delta << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixtures/gpu_sysfs>\n", argv[0]);
+        return 2;
+    }
+    char tmpl[] = "/tmp/gpu_sysfs_XXXXXX";
+    if (!mkdtemp(tmpl)) return 2;
+    const fs::path root = tmpl;
+    fs::copy(argv[1], root, fs::copy_options::recursive | fs::copy_options::copy_symlinks);
+
+    samplingInterval(50);
+    gpuSysfsRoot(root.c_str());
+
+    // First tick: direct readings are complete, idle counters only primed.
+    string json = samples(1);
+    string amd = cardBlock(json, "card0");
+    CHECK(contains(amd, "\"driver\": \"amdgpu\""));
+    CHECK(contains(amd, "\"pciSlot\": \"0000:03:00.0\""));
+    CHECK(contains(amd, "\"engines\": [\"gfx\"]"));
+    CHECK(contains(amd, "\"busy\": 37, \"engineBusy\": [37]"));
+    CHECK(contains(amd, "\"memoryBusy\": 12"));
+    CHECK(contains(amd, "\"vramUsed\": 1073741824, \"vramTotal\": 8589934592"));
+    CHECK(contains(amd, "\"frequencyMHz\": 1800"));
+    CHECK(contains(amd, "\"temperature\": 54"));
+    CHECK(contains(cardBlock(json, "card1"), "\"driver\": \"i915\""));
+    CHECK(contains(cardBlock(json, "card1"), "\"engines\": [\"gt0\", \"gt1\"]"));
+    CHECK(contains(cardBlock(json, "card1"), "\"frequencyMHz\": 1300"));
+    CHECK(contains(cardBlock(json, "card2"), "\"driver\": \"xe\""));
+    CHECK(contains(cardBlock(json, "card2"), "\"engines\": [\"gt0-rc\", \"gt1-mc\"]"));
+    CHECK(!contains(json, "card0-DP-1"));
+
+    // Idle counters that do not move: every GT was busy the whole interval.
+    this_thread::sleep_for(chrono::milliseconds(200));
+    json = samples(1);
+    CHECK(contains(cardBlock(json, "card1"), "\"busy\": 100, \"engineBusy\": [100, 100]"));
+    CHECK(contains(cardBlock(json, "card2"), "\"busy\": 100, \"engineBusy\": [100, 100]"));
+    CHECK(gpuUsages() == 100.0);
+
+    // A jump of idle time longer than the interval reads as fully idle, for
+    // that engine only. The next tick sees it; later ones are busy again.
+    addToCounter(root / "class/drm/card1/gt/gt0/rc6_residency_ms", 10000000);
+    addToCounter(root / "devices/pci0000:00/0000:04:00.0/tile0/gt1/gtidle/idle_residency_ms", 10000000);
+    bool sawIntelIdle = false, sawXeIdle = false;
+    for (int i = 0; i < 60 && !(sawIntelIdle && sawXeIdle); i++) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        json = samples(100);
+        sawIntelIdle = contains(cardBlock(json, "card1"), "\"engineBusy\": [0, 100]");
+        sawXeIdle = contains(cardBlock(json, "card2"), "\"engineBusy\": [100, 0]");
+    }
+    CHECK(sawIntelIdle);
+    CHECK(sawXeIdle);
+
+    // Switching roots re-enumerates and drops the old histories.
+    gpuSysfsRoot((root / "missing").c_str());
+    CHECK(samples(1) == "{ \"gpus\": [] }");
+
+    fs::remove_all(root);
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("gpu_sampler_test: ok\n");
+    return 0;
+}
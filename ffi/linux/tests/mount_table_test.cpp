@@ -0,0 +1,71 @@
+// Parses fixtures/mountinfo/btrfs_host.txt: a btrfs root and /home subvolume
+// on an anonymous 0:31 device, ZFS and overlay mounts, and the usual pseudo
+// filesystems that must be left out.
+#include "../include/mount_table.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+static const MountEntry* findMount(const vector<MountEntry>& mounts, const string& mountPoint) {
+    for (const MountEntry& m : mounts) {
+        if (m.mountPoint == mountPoint) return &m;
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fixtures/mountinfo>\n", argv[0]);
+        return 2;
+    }
+    ifstream in(string(argv[1]) + "/btrfs_host.txt");
+    CHECK(in.good());
+    ostringstream text;
+    text << in.rdbuf();
+    vector<MountEntry> mounts = parseMountInfo(text.str());
+
+    const MountEntry* root = findMount(mounts, "/");
+    CHECK(root != nullptr);
+    if (root) {
+        CHECK(root->major == 0 && root->minor == 31);
+        CHECK(root->fsType == "btrfs");
+        CHECK(root->source == "/dev/nvme0n1p2");
+        CHECK(root->root == "/@");
+        CHECK(!root->network && !root->readOnly);
+    }
+    const MountEntry* home = findMount(mounts, "/home");
+    CHECK(home != nullptr && home->root == "/@home" && home->source == "/dev/nvme0n1p2");
+    CHECK(findMount(mounts, "/boot/efi") != nullptr);
+    CHECK(findMount(mounts, "/tank/home") != nullptr);
+    CHECK(findMount(mounts, "/var/lib/containers/overlay/merged") != nullptr);
+    CHECK(findMount(mounts, "/run") != nullptr);
+    const MountEntry* nas = findMount(mounts, "/mnt/nas");
+    CHECK(nas != nullptr && nas->network);
+    CHECK(findMount(mounts, "/mnt/My Disk") != nullptr);
+
+    for (const char* pseudo : {"/proc", "/sys", "/dev", "/dev/pts", "/sys/fs/cgroup",
+                               "/sys/kernel/debug", "/proc/sys/fs/binfmt_misc"}) {
+        CHECK(findMount(mounts, pseudo) == nullptr);
+    }
+    CHECK(mounts.size() == 8);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("mount_table_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "../include/drm_fdinfo.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// "123 KiB" / "4 MiB" / "4096" (bytes) -> KiB.
+static uint64_t parseMemoryKB(const char* value) {
+    char* end;
+    uint64_t n = strtoull(value, &end, 10);
+    while (*end == ' ') end++;
+    if (strncmp(end, "KiB", 3) == 0) return n;
+    if (strncmp(end, "MiB", 3) == 0) return n * 1024;
+    if (strncmp(end, "GiB", 3) == 0) return n * 1024 * 1024;
+    return n / 1024;
+}
+
+bool parseDrmFdinfo(const string& text, DrmClientUsage& out) {
+    out = DrmClientUsage();
+    bool isClient = false;
+    // Older drivers only report drm-memory-<region>; newer ones add
+    // drm-resident-<region>, which is what is actually in memory.
+    uint64_t memoryKB = 0, residentKB = 0;
+    bool haveResident = false;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == string::npos) eol = text.size();
+        string line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (line.compare(0, 4, "drm-") != 0) continue;
+        size_t colon = line.find(':');
+        if (colon == string::npos) continue;
+        string key = line.substr(4, colon - 4);
+        const char* value = line.c_str() + colon + 1;
+        while (*value == ' ' || *value == '\t') value++;
+
+        if (key == "driver") {
+            out.driver = value;
+        } else if (key == "pdev") {
+            out.pdev = value;
+        } else if (key == "client-id") {
+            out.clientId = strtoull(value, nullptr, 10);
+            isClient = true;
+        } else if (key.compare(0, 7, "engine-") == 0 && key.compare(0, 16, "engine-capacity-") != 0) {
+            out.engineNs[key.substr(7)] = strtoull(value, nullptr, 10);
+        } else if (key.compare(0, 13, "total-cycles-") == 0) {
+            out.totalCycles[key.substr(13)] = strtoull(value, nullptr, 10);
+        } else if (key.compare(0, 7, "cycles-") == 0) {
+            out.cycles[key.substr(7)] = strtoull(value, nullptr, 10);
+        } else if (key.compare(0, 9, "resident-") == 0) {
+            residentKB += parseMemoryKB(value);
+            haveResident = true;
+        } else if (key.compare(0, 7, "memory-") == 0) {
+            memoryKB += parseMemoryKB(value);
+        }
+    }
+    out.memoryKB = haveResident ? residentKB : memoryKB;
+    return isClient;
+}
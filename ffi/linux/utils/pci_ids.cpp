@@ -0,0 +1,148 @@
+#include "../include/pci_ids.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct IdOffset {
+    uint16_t id;
+    uint32_t offset;      // Start of the line in the mapping
+    bool operator<(const IdOffset& o) const { return id < o.id; }
+};
+
+struct VendorEntry {
+    IdOffset line;
+    uint32_t blockEnd;    // End of this vendor's device lines
+};
+
+static mutex pciMutex;
+static const char* pciData = nullptr;
+static size_t pciSize = 0;
+static bool pciMapped = false;
+static vector<VendorEntry> vendorIndex;
+static unordered_map<uint16_t, vector<IdOffset>> deviceIndex;
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Four hex digits at `p` followed by whitespace.
+static bool parseId(const char* p, const char* end, uint16_t& id) {
+    if (end - p < 5) return false;
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hexValue(p[i]);
+        if (h < 0) return false;
+        v = v << 4 | (unsigned)h;
+    }
+    if (p[4] != ' ' && p[4] != '\t') return false;
+    id = (uint16_t)v;
+    return true;
+}
+
+static const char* lineEnd(const char* p) {
+    const char* nl = (const char*)memchr(p, '\n', (size_t)(pciData + pciSize - p));
+    return nl ? nl : pciData + pciSize;
+}
+
+// Name part of "vvvv  Name" / "\tdddd  Name".
+static string nameAt(uint32_t offset, size_t indent) {
+    const char* p = pciData + offset + indent + 4;
+    const char* end = lineEnd(p);
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return string(p, (size_t)(end - p));
+}
+
+// Caller holds pciMutex. Maps the file and builds the vendor table once.
+static bool ensureVendorIndex() {
+    if (pciMapped) return pciData != nullptr;
+    pciMapped = true;
+    static const char* candidates[] = {
+        "/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", "/usr/share/pci.ids"
+    };
+    for (const char* path : candidates) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size < 0xffffffffULL) {
+            void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                pciData = (const char*)map;
+                pciSize = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+        if (pciData) break;
+    }
+    if (!pciData) return false;
+
+    // Vendor lines start with a hex digit; the device classes section
+    // ("C 00  ...") at the end is not indexed.
+    const char* end = pciData + pciSize;
+    const char* p = pciData;
+    while (p < end && !(*p == 'C' && p + 1 < end && p[1] == ' ')) {
+        uint16_t id;
+        if (hexValue(*p) >= 0 && parseId(p, end, id)) {
+            if (!vendorIndex.empty()) vendorIndex.back().blockEnd = (uint32_t)(p - pciData);
+            vendorIndex.push_back(VendorEntry{IdOffset{id, (uint32_t)(p - pciData)}, 0});
+        }
+        p = lineEnd(p) + 1;
+    }
+    if (!vendorIndex.empty()) vendorIndex.back().blockEnd = (uint32_t)(min(p, end) - pciData);
+    stable_sort(vendorIndex.begin(), vendorIndex.end(),
+                [](const VendorEntry& a, const VendorEntry& b) { return a.line < b.line; });
+    return true;
+}
+
+static const VendorEntry* findVendor(uint16_t vendor) {
+    auto it = lower_bound(vendorIndex.begin(), vendorIndex.end(), vendor,
+                          [](const VendorEntry& e, uint16_t id) { return e.line.id < id; });
+    return it != vendorIndex.end() && it->line.id == vendor ? &*it : nullptr;
+}
+
+bool pciVendorName(uint16_t vendor, string& name) {
+    lock_guard<mutex> lock(pciMutex);
+    if (!ensureVendorIndex()) return false;
+    const VendorEntry* v = findVendor(vendor);
+    if (!v) return false;
+    name = nameAt(v->line.offset, 0);
+    return true;
+}
+
+bool pciDeviceName(uint16_t vendor, uint16_t device, string& name) {
+    lock_guard<mutex> lock(pciMutex);
+    if (!ensureVendorIndex()) return false;
+    const VendorEntry* v = findVendor(vendor);
+    if (!v) return false;
+
+    auto cached = deviceIndex.find(vendor);
+    if (cached == deviceIndex.end()) {
+        // One tab: device; two tabs: subsystem (skipped).
+        vector<IdOffset> devices;
+        const char* end = pciData + v->blockEnd;
+        for (const char* p = lineEnd(pciData + v->line.offset) + 1; p < end; p = lineEnd(p) + 1) {
+            uint16_t id;
+            if (p[0] == '\t' && p + 1 < end && p[1] != '\t' && parseId(p + 1, end, id)) {
+                devices.push_back(IdOffset{id, (uint32_t)(p - pciData)});
+            }
+        }
+        stable_sort(devices.begin(), devices.end());
+        cached = deviceIndex.emplace(vendor, std::move(devices)).first;
+    }
+    const vector<IdOffset>& devices = cached->second;
+    auto it = lower_bound(devices.begin(), devices.end(), IdOffset{device, 0});
+    if (it == devices.end() || it->id != device) return false;
+    name = nameAt(it->offset, 1);
+    return true;
+}
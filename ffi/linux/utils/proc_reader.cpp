@@ -0,0 +1,151 @@
+#include "../include/proc_reader.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+using namespace std;
+
+static bool readAll(int fd, string& out) {
+    out.clear();
+    if (fd < 0) return false;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        out.append(buffer, (size_t)n);
+    }
+    close(fd);
+    return n == 0;
+}
+
+bool readFile(const char* path, string& out) {
+    return readAll(open(path, O_RDONLY | O_CLOEXEC), out);
+}
+
+bool readFileAt(int dirfd, const char* name, string& out) {
+    return readAll(openat(dirfd, name, O_RDONLY | O_CLOEXEC), out);
+}
+
+uint64_t findKbField(const string& text, const char* key) {
+    size_t keyLen = strlen(key);
+    size_t pos = 0;
+    while ((pos = text.find(key, pos)) != string::npos) {
+        // Only accept matches at the start of a line followed by ':'.
+        if ((pos == 0 || text[pos - 1] == '\n') && text.compare(pos + keyLen, 1, ":") == 0) {
+            return strtoull(text.c_str() + pos + keyLen + 1, nullptr, 10);
+        }
+        pos += keyLen;
+    }
+    return 0;
+}
+
+bool parseProcStat(const string& text, ProcStat& stat) {
+    // comm may itself contain spaces and parentheses, so split on the last ')'.
+    size_t open = text.find('(');
+    size_t close = text.rfind(')');
+    if (open == string::npos || close == string::npos || close < open || close + 2 >= text.size()) {
+        return false;
+    }
+    stat.comm = text.substr(open + 1, close - open - 1);
+    stat.state = text[close + 2];
+
+    // Fields 4..24 of proc(5), numbered from ppid.
+    uint64_t fields[21] = {0};
+    const char* p = text.c_str() + close + 3;
+    for (int i = 0; i < 21; i++) {
+        char* end = nullptr;
+        fields[i] = strtoull(p, &end, 10);
+        if (end == p) return false;
+        p = end;
+    }
+    stat.ppid = (int)fields[0];
+    stat.minorFaults = fields[6];
+    stat.majorFaults = fields[8];
+    stat.utimeTicks = fields[10];
+    stat.stimeTicks = fields[11];
+    stat.numThreads = (int)fields[16];
+    stat.startTicks = fields[18];
+    stat.rssPages = fields[20];
+    return true;
+}
+
+bool readProcIo(int pidFd, uint64_t& readBytes, uint64_t& writeBytes) {
+    string text;
+    readBytes = writeBytes = 0;
+    if (!readFileAt(pidFd, "io", text) || text.empty()) return false;
+    readBytes = findKbField(text, "read_bytes");
+    writeBytes = findKbField(text, "write_bytes");
+    return true;
+}
+
+string jsonEscape(const string& str) {
+    string result;
+    result.reserve(str.size());
+    for (unsigned char c : str) {
+        switch (c) {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    result += buf;
+                } else {
+                    result += (char)c;
+                }
+        }
+    }
+    return result;
+}
+
+long clockTicksPerSecond() {
+    static const long ticks = sysconf(_SC_CLK_TCK);
+    return ticks > 0 ? ticks : 100;
+}
+
+long pageSizeKB() {
+    static const long pageKB = sysconf(_SC_PAGESIZE) / 1024;
+    return pageKB > 0 ? pageKB : 4;
+}
+
+uint64_t bootTimeSeconds() {
+    static uint64_t bootTime = 0;
+    if (bootTime == 0) {
+        string stat;
+        if (readFile("/proc/stat", stat)) {
+            size_t pos = stat.find("\nbtime ");
+            if (pos != string::npos) {
+                bootTime = strtoull(stat.c_str() + pos + 7, nullptr, 10);
+            }
+        }
+    }
+    return bootTime;
+}
+
+string blockDeviceName(dev_t dev, bool wholeDisk) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u", major(dev), minor(dev));
+    char target[4096];
+    ssize_t len = readlink(path, target, sizeof(target) - 1);
+    if (len <= 0) return "";
+    target[len] = '\0';
+    // ../../devices/pci0000:00/.../block/nvme0n1/nvme0n1p2
+    string link(target);
+    size_t slash = link.find_last_of('/');
+    string name = link.substr(slash + 1);
+    if (wholeDisk) {
+        struct stat st;
+        string partition = string(path) + "/partition";
+        if (stat(partition.c_str(), &st) == 0 && slash != string::npos && slash > 0) {
+            size_t parent = link.find_last_of('/', slash - 1);
+            name = link.substr(parent + 1, slash - parent - 1);
+        }
+    }
+    return name;
+}
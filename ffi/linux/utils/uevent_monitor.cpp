@@ -0,0 +1,49 @@
+#include "../include/uevent_monitor.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+int openUeventSocket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) return -1;
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1; // Kernel events (group 2 is udev's re-broadcast)
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool drainUevents(int fd, const char* subsystem) {
+    // Payload is "action@devpath\0KEY=value\0KEY=value\0..."
+    string wanted = string("SUBSYSTEM=") + subsystem;
+    char buf[8192];
+    bool matched = false;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+        if (n < 0) {
+            // The socket overflowed and events were lost; assume ours was one.
+            if (errno == ENOBUFS) {
+                matched = true;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t i = 0; i < (size_t)n && !matched;) {
+            const char* field = buf + i;
+            size_t len = strnlen(field, (size_t)n - i);
+            if (len == wanted.size() && memcmp(field, wanted.data(), len) == 0) matched = true;
+            i += len + 1;
+        }
+    }
+    return matched;
+}
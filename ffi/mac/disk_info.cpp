@@ -74,6 +74,8 @@ static void parseDiskUtilInfo(const string &diskUtilOutput,
 }
 
 // Run disk speed test asynchronously
+// The values are placeholders. The O_DIRECT benchmark (diskBenchmarkStart) is
+// Linux only; macOS would need an F_NOCACHE port of it.
 static void measureDiskSpeed(double &readSpeed, double &writeSpeed) {
     thread writeThread([&]() {
         string writeOutput = execCommand("dd if=/dev/zero of=./speedtest bs=1m count=512 oflag=sync 2>&1");
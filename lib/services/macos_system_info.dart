@@ -20,8 +20,12 @@ final DynamicLibrary _lib = () {
     final String libPath = '$directory/libmac_system_info.dylib';
 
     return DynamicLibrary.open(libPath);
+  } else if (Platform.isLinux) {
+    // The library is installed next to the Flutter engine in the bundle's lib/ folder.
+    final String directory = File(Platform.resolvedExecutable).parent.path;
+    return DynamicLibrary.open('$directory/lib/liblinux_system_info.so');
   } else {
-    throw UnsupportedError('This FFI module only supports macOS.');
+    throw UnsupportedError('This FFI module only supports macOS and Linux.');
   }
 }();
 